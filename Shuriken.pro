@@ -208,6 +208,17 @@ SOURCES += src/JuceLibraryCode/modules/juce_audio_basics/juce_audio_basics.cpp \
     src/nsmlistenerthread.cpp \
     src/jackoutputsdialog.cpp \
     src/sampleutils.cpp \
+    src/zerocrossingindex.cpp \
+    src/peakpyramid.cpp \
+    src/audiometer.cpp \
+    src/audiometerwidget.cpp \
+    src/zipwriter.cpp \
+    src/projectreader.cpp \
+    src/sliceexporter.cpp \
+    src/samplekernels.cpp \
+    src/targzwriter.cpp \
+    src/slicerenderer.cpp \
+    src/offlinebouncer.cpp \
     src/calcbpmdialog.cpp
 HEADERS += src/JuceLibraryCode/JuceHeader.h \
     src/JuceLibraryCode/AppConfig.h \
@@ -448,6 +459,17 @@ HEADERS += src/JuceLibraryCode/JuceHeader.h \
     src/nsmlistenerthread.h \
     src/jackoutputsdialog.h \
     src/sampleutils.h \
+    src/zerocrossingindex.h \
+    src/peakpyramid.h \
+    src/audiometer.h \
+    src/audiometerwidget.h \
+    src/zipwriter.h \
+    src/projectreader.h \
+    src/sliceexporter.h \
+    src/samplekernels.h \
+    src/targzwriter.h \
+    src/slicerenderer.h \
+    src/offlinebouncer.h \
     src/calcbpmdialog.h
 FORMS += src/mainwindow.ui \
     src/optionsdialog.ui \
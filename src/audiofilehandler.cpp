@@ -21,8 +21,10 @@
 */
 
 #include "audiofilehandler.h"
+#include "samplekernels.h"
 #include <samplerate.h>
 #include <QDir>
+#include <QCryptographicHash>
 #include <QDebug>
 
 
@@ -167,27 +169,7 @@ QString AudioFileHandler::saveAudioFile( const QString dirPath,
         sfInfo.channels   = numChans;
         sfInfo.format     = sndFileFormat;
 
-        switch ( sndFileFormat & SF_FORMAT_TYPEMASK )
-        {
-        case SF_FORMAT_WAV:
-            filePath.append( ".wav" );
-            break;
-        case SF_FORMAT_AIFF:
-            filePath.append( ".aiff" );
-            break;
-        case SF_FORMAT_AU:
-            filePath.append( ".au" );
-            break;
-        case SF_FORMAT_FLAC:
-            filePath.append( ".flac" );
-            break;
-        case SF_FORMAT_OGG:
-            filePath.append( ".ogg" );
-            break;
-        default:
-            qDebug() << "Unknown format: " << sndFileFormat;
-            break;
-        }
+        filePath.append( getFileExtension( sndFileFormat ) );
 
         Q_ASSERT( sf_format_check( &sfInfo ) );
 
@@ -205,14 +187,7 @@ QString AudioFileHandler::saveAudioFile( const QString dirPath,
                 {
                     const qreal sampleRateRatio = (qreal) outputSampleRate / (qreal) currentSampleRate;
 
-                    Array<float> interleavedBuffer;
-
-                    isSuccessful = convertSampleRate( sampleBuffer, sampleRateRatio, interleavedBuffer );
-
-                    if ( isSuccessful )
-                    {
-                        isSuccessful = sndfileSaveAudioFile( fileID, interleavedBuffer, hopSize * numChans );
-                    }
+                    isSuccessful = sndfileSaveAudioFile( fileID, sampleBuffer, sampleRateRatio, hopSize );
                 }
                 sf_write_sync( fileID );
                 sf_close( fileID );
@@ -242,101 +217,493 @@ QString AudioFileHandler::saveAudioFile( const QString dirPath,
 
 
 
-//==================================================================================================
-// Private Static:
+bool AudioFileHandler::encodeAudioData( const SharedSampleBuffer sampleBuffer,
+                                        const int currentSampleRate,
+                                        const int outputSampleRate,
+                                        const int sndFileFormat,
+                                        MemoryBlock& fileData )
+{
+    Q_ASSERT( currentSampleRate != 0 );
 
-QString AudioFileHandler::s_errorTitle;
-QString AudioFileHandler::s_errorInfo;
+    const int hopSize = 8192;
 
+    SF_INFO sfInfo;
+    memset( &sfInfo, 0, sizeof( SF_INFO ) );
 
-void AudioFileHandler::interleaveSamples( const SharedSampleBuffer inputBuffer,
-                                          const int numChans,
-                                          const int inputStartFrame,
-                                          const int numFrames,
-                                          Array<float>& outputBuffer )
+    sfInfo.samplerate = outputSampleRate;
+    sfInfo.channels   = sampleBuffer->getNumChannels();
+    sfInfo.format     = sndFileFormat;
+
+    Q_ASSERT( sf_format_check( &sfInfo ) );
+
+    SF_VIRTUAL_IO virtualIO;
+
+    virtualIO.get_filelen = sndfileGetMemoryLength;
+    virtualIO.seek        = sndfileSeekMemory;
+    virtualIO.read        = sndfileReadMemory;
+    virtualIO.write       = sndfileWriteMemory;
+    virtualIO.tell        = sndfileTellMemory;
+
+    fileData.setSize( 0 );
+
+    bool isSuccessful = false;
+
+    {
+        MemoryOutputStream memory( fileData, false );
+
+        SNDFILE* fileID = sf_open_virtual( &virtualIO, SFM_WRITE, &sfInfo, &memory );
+
+        if ( fileID == NULL )
+        {
+            s_errorTitle = "Couldn't encode audio data";
+            s_errorInfo = sf_strerror( NULL );
+            return false;
+        }
+
+        if ( outputSampleRate == currentSampleRate )
+        {
+            isSuccessful = sndfileSaveAudioFile( fileID, sampleBuffer, hopSize );
+        }
+        else
+        {
+            const qreal sampleRateRatio = (qreal) outputSampleRate / (qreal) currentSampleRate;
+
+            isSuccessful = sndfileSaveAudioFile( fileID, sampleBuffer, sampleRateRatio, hopSize );
+        }
+
+        sf_close( fileID );
+    }
+
+    return isSuccessful;
+}
+
+
+
+bool AudioFileHandler::saveAudioStream( OutputStream& stream,
+                                        const SharedSampleBuffer sampleBuffer,
+                                        const int sampleRate,
+                                        QByteArray& fileHash )
 {
-    for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+    const int hopSize = 8192;
+    const int numChans = sampleBuffer->getNumChannels();
+    const int totalNumFrames = sampleBuffer->getNumFrames();
+    const int bytesPerFrame = numChans * (int) sizeof( float );
+    const int64 dataSize = (int64) totalNumFrames * bytesPerFrame;
+    const int64 riffSize = 4 + ( 8 + 18 ) + ( 8 + 4 ) + ( 8 + dataSize );
+
+    // RIFF chunk sizes are 32-bit
+    if ( riffSize > (int64) 0xFFFFFFFF )
+    {
+        s_errorTitle = "Couldn't write audio data";
+        s_errorInfo = "The audio is too long to be saved as a WAV file";
+        return false;
+    }
+
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+
+    // The length of the audio is known in advance, so the header can be written first and never needs updating
+    MemoryOutputStream header;
+
+    header.write( "RIFF", 4 );
+    header.writeInt( (int) (uint32) riffSize );
+    header.write( "WAVE", 4 );
+
+    header.write( "fmt ", 4 );
+    header.writeInt( 18 );
+    header.writeShort( 3 ); // WAVE_FORMAT_IEEE_FLOAT
+    header.writeShort( (short) numChans );
+    header.writeInt( sampleRate );
+    header.writeInt( sampleRate * bytesPerFrame );
+    header.writeShort( (short) bytesPerFrame );
+    header.writeShort( 32 );
+    header.writeShort( 0 );
+
+    header.write( "fact", 4 );
+    header.writeInt( 4 );
+    header.writeInt( totalNumFrames );
+
+    header.write( "data", 4 );
+    header.writeInt( (int) (uint32) dataSize );
+
+    hash.addData( static_cast<const char*>( header.getData() ), (int) header.getDataSize() );
+
+    if ( ! stream.write( header.getData(), header.getDataSize() ) )
     {
-        const float* sampleData = inputBuffer->getReadPointer( chanNum, inputStartFrame );
+        s_errorTitle = "Couldn't write audio data";
+        s_errorInfo = "An error occurred while writing the audio data";
+        return false;
+    }
+
+    Array<float> tempBuffer;
+    tempBuffer.resize( hopSize * numChans );
 
-        for ( int frameNum = 0; frameNum < numFrames; ++frameNum )
+    for ( int startFrame = 0; startFrame < totalNumFrames; startFrame += hopSize )
+    {
+        const int numFramesToWrite = jmin( hopSize, totalNumFrames - startFrame );
+
+        interleaveSamples( sampleBuffer, numChans, startFrame, numFramesToWrite, tempBuffer );
+
+      #if JUCE_BIG_ENDIAN
+        uint32* const words = reinterpret_cast<uint32*>( tempBuffer.getRawDataPointer() );
+
+        for ( int i = 0; i < numFramesToWrite * numChans; i++ )
+        {
+            words[ i ] = ByteOrder::swap( words[ i ] );
+        }
+      #endif
+
+        const char* const bytes = reinterpret_cast<const char*>( tempBuffer.getRawDataPointer() );
+        const int numBytes = numFramesToWrite * bytesPerFrame;
+
+        hash.addData( bytes, numBytes );
+
+        if ( ! stream.write( bytes, (size_t) numBytes ) )
         {
-            outputBuffer.set( numChans * frameNum + chanNum,    // Index
-                              sampleData[ frameNum ] );         // Value
+            s_errorTitle = "Couldn't write audio data";
+            s_errorInfo = "An error occurred while writing the audio data";
+            return false;
         }
     }
+
+    fileHash = hash.result();
+
+    return true;
 }
 
 
 
-void AudioFileHandler::deinterleaveSamples( Array<float>& inputBuffer,
-                                            const int numChans,
-                                            const int outputStartFrame,
-                                            const int numFrames,
-                                            SharedSampleBuffer outputBuffer )
+bool AudioFileHandler::saveFlacStream( OutputStream& stream,
+                                       const SharedSampleBuffer sampleBuffer,
+                                       const int sampleRate,
+                                       QByteArray& fileHash )
 {
-    const float* inputSampleData = inputBuffer.getRawDataPointer();
+    const int hopSize = 8192;
 
-    for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+    SF_INFO sfInfo;
+    memset( &sfInfo, 0, sizeof( SF_INFO ) );
+
+    sfInfo.samplerate = sampleRate;
+    sfInfo.channels   = sampleBuffer->getNumChannels();
+    sfInfo.format     = SF_FORMAT_FLAC | SF_FORMAT_PCM_24;
+
+    SF_VIRTUAL_IO virtualIO;
+
+    virtualIO.get_filelen = sndfileGetMemoryLength;
+    virtualIO.seek        = sndfileSeekMemory;
+    virtualIO.read        = sndfileReadMemory;
+    virtualIO.write       = sndfileWriteMemory;
+    virtualIO.tell        = sndfileTellMemory;
+
+    // The FLAC encoder seeks back to update the stream info once it has finished, so the file is encoded into memory
+    // and then written to the stream. Being compressed, it is far smaller than the sample data
+    MemoryOutputStream encodedData;
+
+    SNDFILE* fileID = sf_open_virtual( &virtualIO, SFM_WRITE, &sfInfo, &encodedData );
+
+    if ( fileID == NULL )
+    {
+        s_errorTitle = "Couldn't encode audio data";
+        s_errorInfo = sf_strerror( NULL );
+        return false;
+    }
+
+    sf_command( fileID, SFC_SET_CLIPPING, NULL, SF_TRUE );
+
+    bool isSuccessful = sndfileSaveAudioFile( fileID, sampleBuffer, hopSize, 24 );
+
+    sf_close( fileID );
+
+    if ( isSuccessful )
     {
-        float* outputSampleData = outputBuffer->getWritePointer( chanNum, outputStartFrame );
+        const QByteArray bytes = QByteArray::fromRawData( static_cast<const char*>( encodedData.getData() ),
+                                                          (int) encodedData.getDataSize() );
 
-        for ( int frameNum = 0; frameNum < numFrames; ++frameNum )
+        fileHash = QCryptographicHash::hash( bytes, QCryptographicHash::Md5 );
+
+        isSuccessful = stream.write( encodedData.getData(), encodedData.getDataSize() );
+
+        if ( ! isSuccessful )
         {
-            outputSampleData[ frameNum ] = inputSampleData[ numChans * frameNum + chanNum ];
+            s_errorTitle = "Couldn't write audio data";
+            s_errorInfo = "An error occurred while writing the audio data";
         }
     }
+
+    return isSuccessful;
 }
 
 
 
-bool AudioFileHandler::convertSampleRate( const SharedSampleBuffer inputBuffer,
-                                          const qreal sampleRateRatio,
-                                          Array<float>& outputBuffer )
+bool AudioFileHandler::savePeakStream( OutputStream& stream, const QByteArray audioFileHash, const SharedSampleBuffer sampleBuffer )
+{
+    if ( audioFileHash.isEmpty() )
+    {
+        return false;
+    }
+
+    stream.writeInt( audioFileHash.size() );
+    stream.write( audioFileHash.constData(), audioFileHash.size() );
+
+    sampleBuffer->writePeaks( stream );
+
+    return true;
+}
+
+
+
+//==================================================================================================
+// Public Static:
+
+SharedSampleBuffer AudioFileHandler::readAudioHeader( InputStream& stream, SharedSampleHeader& sampleHeader )
 {
-    const int inputNumFrames = inputBuffer->getNumFrames();
-    const int numChans = inputBuffer->getNumChannels();
+    SharedSampleBuffer sampleBuffer;
+
+    SF_VIRTUAL_IO virtualIO;
+
+    virtualIO.get_filelen = sndfileGetStreamLength;
+    virtualIO.seek        = sndfileSeekStream;
+    virtualIO.read        = sndfileReadStream;
+    virtualIO.write       = sndfileWriteStream;
+    virtualIO.tell        = sndfileTellStream;
+
+    LazyInputStream input;
+    input.stream = &stream;
+    input.position = stream.getPosition();
+
+    SF_INFO sfInfo;
+    memset( &sfInfo, 0, sizeof( SF_INFO ) );
 
-    const long outputNumFrames = roundToIntAccurate( inputNumFrames * sampleRateRatio );
+    SNDFILE* fileID = sf_open_virtual( &virtualIO, SFM_READ, &sfInfo, &input );
 
-    if ( outputBuffer.size() != outputNumFrames * numChans )
+    if ( fileID == NULL )
     {
-        outputBuffer.resize( outputNumFrames * numChans );
+        return sampleBuffer;
     }
 
-    Array<float> tempBuffer;
-    tempBuffer.resize( inputNumFrames * numChans );
+    sf_close( fileID );
 
-    interleaveSamples( inputBuffer, numChans, 0, inputNumFrames, tempBuffer );
+    if ( sfInfo.channels >= 1 && sfInfo.channels <= 2 && sfInfo.frames > 0 && sfInfo.samplerate > 0 )
+    {
+        try
+        {
+            sampleBuffer = SharedSampleBuffer( SampleBuffer::createPlaceholder( sfInfo.channels, sfInfo.frames ) );
+        }
+        catch ( std::bad_alloc& )
+        {
+            sampleBuffer.clear();
+        }
+    }
 
-    SRC_DATA srcData;
-    memset( &srcData, 0, sizeof( SRC_DATA ) );
+    if ( ! sampleBuffer.isNull() )
+    {
+        SF_FORMAT_INFO formatInfo;
+        memset( &formatInfo, 0, sizeof( SF_FORMAT_INFO ) );
+        formatInfo.format = sfInfo.format & SF_FORMAT_TYPEMASK;
+        sf_command( NULL, SFC_GET_FORMAT_MAJOR, &formatInfo, sizeof( SF_FORMAT_INFO ) );
 
-    srcData.data_in = tempBuffer.getRawDataPointer();
-    srcData.data_out = outputBuffer.getRawDataPointer();
+        sampleHeader = SharedSampleHeader( new SampleHeader );
 
-    srcData.input_frames = inputNumFrames;
-    srcData.output_frames = outputNumFrames;
+        sampleHeader->format = formatInfo.name != NULL ? formatInfo.name : "";
+        sampleHeader->numChans = sfInfo.channels;
+        sampleHeader->sampleRate = sfInfo.samplerate;
 
-    srcData.src_ratio = sampleRateRatio;
+        switch ( sfInfo.format & SF_FORMAT_SUBMASK )
+        {
+        case SF_FORMAT_PCM_S8:
+        case SF_FORMAT_PCM_U8:
+            sampleHeader->bitsPerSample = 8;
+            break;
+        case SF_FORMAT_PCM_16:
+            sampleHeader->bitsPerSample = 16;
+            break;
+        case SF_FORMAT_PCM_24:
+            sampleHeader->bitsPerSample = 24;
+            break;
+        case SF_FORMAT_PCM_32:
+        case SF_FORMAT_FLOAT:
+            sampleHeader->bitsPerSample = 32;
+            break;
+        case SF_FORMAT_DOUBLE:
+            sampleHeader->bitsPerSample = 64;
+            break;
+        default:
+            sampleHeader->bitsPerSample = 0;
+            break;
+        }
+    }
 
-    bool isSuccessful = true;
+    return sampleBuffer;
+}
+
+
+
+bool AudioFileHandler::decodeAudioData( MemoryBlock& fileData, const SharedSampleBuffer sampleBuffer )
+{
+    const sf_count_t hopSize = 4096;
+
+    SF_VIRTUAL_IO virtualIO;
 
-    const int errorCode = src_simple( &srcData, SRC_SINC_BEST_QUALITY, numChans );
+    virtualIO.get_filelen = sndfileGetMemoryLength;
+    virtualIO.seek        = sndfileSeekMemory;
+    virtualIO.read        = sndfileReadMemory;
+    virtualIO.write       = sndfileWriteMemory;
+    virtualIO.tell        = sndfileTellMemory;
 
-    if ( errorCode > 0 )
+    // Wrap the file data without copying it
+    MemoryOutputStream memory( fileData, true );
+    memory.setPosition( 0 );
+
+    SF_INFO sfInfo;
+    memset( &sfInfo, 0, sizeof( SF_INFO ) );
+
+    SNDFILE* fileID = sf_open_virtual( &virtualIO, SFM_READ, &sfInfo, &memory );
+
+    if ( fileID == NULL )
     {
-        s_errorTitle = "Couldn't convert sample rate!";
-        s_errorInfo = src_strerror( errorCode );
-        isSuccessful = false;
+        return false;
     }
 
-    return isSuccessful;
+    sf_count_t totalNumFramesRead = 0;
+
+    // The data must still have the size given by its header when the placeholder was created
+    if ( sfInfo.channels == sampleBuffer->getNumChannels() && sfInfo.frames == sampleBuffer->getNumFrames() )
+    {
+        Array<float> tempBuffer;
+        tempBuffer.resize( hopSize * sfInfo.channels );
+
+        sf_count_t numFramesRead = 0;
+
+        do
+        {
+            numFramesRead = sf_readf_float( fileID, tempBuffer.getRawDataPointer(), jmin( hopSize, sfInfo.frames - totalNumFramesRead ) );
+
+            deinterleaveSamples( tempBuffer, sfInfo.channels, totalNumFramesRead, numFramesRead, sampleBuffer );
+
+            totalNumFramesRead += numFramesRead;
+        }
+        while ( numFramesRead > 0 && totalNumFramesRead < sfInfo.frames );
+    }
+
+    sf_close( fileID );
+
+    return totalNumFramesRead == sampleBuffer->getNumFrames();
+}
+
+
+
+bool AudioFileHandler::loadPeakStream( InputStream& stream, const QByteArray audioFileHash, const SharedSampleBuffer sampleBuffer )
+{
+    if ( audioFileHash.isEmpty() )
+    {
+        return false;
+    }
+
+    const int hashSize = stream.readInt();
+
+    if ( hashSize <= 0 || hashSize > 64 )
+    {
+        return false;
+    }
+
+    QByteArray storedHash( hashSize, 0 );
+
+    if ( stream.read( storedHash.data(), hashSize ) != hashSize || storedHash != audioFileHash )
+    {
+        return false;
+    }
+
+    return sampleBuffer->readPeaks( stream );
+}
+
+
+
+QString AudioFileHandler::getFileExtension( const int sndFileFormat )
+{
+    switch ( sndFileFormat & SF_FORMAT_TYPEMASK )
+    {
+    case SF_FORMAT_WAV:
+        return ".wav";
+    case SF_FORMAT_AIFF:
+        return ".aiff";
+    case SF_FORMAT_AU:
+        return ".au";
+    case SF_FORMAT_FLAC:
+        return ".flac";
+    case SF_FORMAT_OGG:
+        return ".ogg";
+    default:
+        qDebug() << "Unknown format: " << sndFileFormat;
+        return QString();
+    }
+}
+
+
+
+int AudioFileHandler::getCompressionLevel( const ProjectStorage storage )
+{
+    switch ( storage )
+    {
+    case STORE_WAV_FAST:
+        return 1;
+    case STORE_WAV_SMALLEST:
+        return 9;
+    default:
+        // FLAC data is already compressed, so it's stored as it is
+        return 0;
+    }
 }
 
 
 
-bool AudioFileHandler::sndfileSaveAudioFile( SNDFILE* fileID, const SharedSampleBuffer sampleBuffer, const int hopSize )
+//==================================================================================================
+// Private Static:
+
+thread_local QString AudioFileHandler::s_errorTitle;
+thread_local QString AudioFileHandler::s_errorInfo;
+
+
+void AudioFileHandler::interleaveSamples( const SharedSampleBuffer inputBuffer,
+                                          const int numChans,
+                                          const int inputStartFrame,
+                                          const int numFrames,
+                                          Array<float>& outputBuffer )
+{
+    jassert( outputBuffer.size() >= numChans * numFrames );
+
+    HeapBlock<const float*> inputChannels( numChans );
+
+    for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+    {
+        inputChannels[ chanNum ] = inputBuffer->getReadPointer( chanNum, inputStartFrame );
+    }
+
+    SampleKernels::interleave( inputChannels, numChans, numFrames, outputBuffer.getRawDataPointer() );
+}
+
+
+
+void AudioFileHandler::deinterleaveSamples( Array<float>& inputBuffer,
+                                            const int numChans,
+                                            const int outputStartFrame,
+                                            const int numFrames,
+                                            SharedSampleBuffer outputBuffer )
+{
+    HeapBlock<float*> outputChannels( numChans );
+
+    for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+    {
+        outputChannels[ chanNum ] = outputBuffer->getWritePointer( chanNum, outputStartFrame );
+    }
+
+    SampleKernels::deinterleave( inputBuffer.getRawDataPointer(), numChans, numFrames, outputChannels );
+}
+
+
+
+bool AudioFileHandler::sndfileSaveAudioFile( SNDFILE* fileID,
+                                             const SharedSampleBuffer sampleBuffer,
+                                             const int hopSize,
+                                             const int clippedPcmBitDepth )
 {
     const int totalNumFrames = sampleBuffer->getNumFrames();
     const int numChans = sampleBuffer->getNumChannels();
@@ -348,6 +715,13 @@ bool AudioFileHandler::sndfileSaveAudioFile( SNDFILE* fileID, const SharedSample
     Array<float> tempBuffer;
     tempBuffer.resize( hopSize * numChans );
 
+    HeapBlock<int> pcmBuffer;
+
+    if ( clippedPcmBitDepth > 0 )
+    {
+        pcmBuffer.malloc( hopSize * numChans );
+    }
+
     bool isSuccessful = true;
 
     do
@@ -356,7 +730,16 @@ bool AudioFileHandler::sndfileSaveAudioFile( SNDFILE* fileID, const SharedSample
 
         interleaveSamples( sampleBuffer, numChans, startFrame, numFramesToWrite, tempBuffer );
 
-        numSamplesWritten = sf_write_float( fileID, tempBuffer.getRawDataPointer(), numFramesToWrite * numChans );
+        if ( clippedPcmBitDepth > 0 )
+        {
+            SampleKernels::floatToPcmClipped( tempBuffer.getRawDataPointer(), numFramesToWrite * numChans, clippedPcmBitDepth, pcmBuffer );
+
+            numSamplesWritten = sf_write_int( fileID, pcmBuffer, numFramesToWrite * numChans );
+        }
+        else
+        {
+            numSamplesWritten = sf_write_float( fileID, tempBuffer.getRawDataPointer(), numFramesToWrite * numChans );
+        }
 
         if ( numSamplesWritten != numFramesToWrite * numChans )
         {
@@ -373,39 +756,99 @@ bool AudioFileHandler::sndfileSaveAudioFile( SNDFILE* fileID, const SharedSample
 
 
 
-bool AudioFileHandler::sndfileSaveAudioFile( SNDFILE* fileID, const Array<float> interleavedBuffer, const int hopSize )
+bool AudioFileHandler::sndfileSaveAudioFile( SNDFILE* fileID,
+                                             const SharedSampleBuffer sampleBuffer,
+                                             const qreal sampleRateRatio,
+                                             const int hopSize )
 {
-    const int totalNumSamples = interleavedBuffer.size();
+    const int totalNumFrames = sampleBuffer->getNumFrames();
+    const int numChans = sampleBuffer->getNumChannels();
 
-    int numSamplesToWrite = 0;
-    int startSample = 0;
-    int numSamplesWritten = 0;
+    // The converted audio is trimmed to exactly this length
+    const int64 totalNumOutputFrames = roundToIntAccurate( totalNumFrames * sampleRateRatio );
 
-    Array<float> tempBuffer;
-    tempBuffer.resize( hopSize );
+    // Room for all the frames that converting one hop of input can produce
+    const int outputHopSize = (int) std::ceil( hopSize * sampleRateRatio ) + 1;
+
+    int errorCode = 0;
+
+    SRC_STATE* srcState = src_new( SRC_SINC_BEST_QUALITY, numChans, &errorCode );
+
+    if ( srcState == NULL )
+    {
+        s_errorTitle = "Couldn't convert sample rate!";
+        s_errorInfo = src_strerror( errorCode );
+        return false;
+    }
+
+    Array<float> inputBuffer;
+    inputBuffer.resize( hopSize * numChans );
+
+    Array<float> outputBuffer;
+    outputBuffer.resize( outputHopSize * numChans );
+
+    SRC_DATA srcData;
+    memset( &srcData, 0, sizeof( SRC_DATA ) );
+
+    srcData.data_out = outputBuffer.getRawDataPointer();
+    srcData.output_frames = outputHopSize;
+    srcData.src_ratio = sampleRateRatio;
+
+    int startFrame = 0;
+    int64 numOutputFramesWritten = 0;
 
     bool isSuccessful = true;
 
-    do
+    while ( isSuccessful && numOutputFramesWritten < totalNumOutputFrames )
     {
-        numSamplesToWrite = totalNumSamples - startSample >= hopSize ? hopSize : totalNumSamples - startSample;
+        // Refill the input buffer once the converter has used all of it
+        if ( srcData.input_frames == 0 && startFrame < totalNumFrames )
+        {
+            const int numFrames = jmin( hopSize, totalNumFrames - startFrame );
+
+            interleaveSamples( sampleBuffer, numChans, startFrame, numFrames, inputBuffer );
+
+            srcData.data_in = inputBuffer.getRawDataPointer();
+            srcData.input_frames = numFrames;
+
+            startFrame += numFrames;
+        }
+
+        srcData.end_of_input = startFrame == totalNumFrames ? 1 : 0;
+
+        errorCode = src_process( srcState, &srcData );
 
-        for ( int i = 0; i < numSamplesToWrite; i++ )
+        if ( errorCode > 0 )
         {
-            tempBuffer.setUnchecked( i, interleavedBuffer.getUnchecked( startSample + i ) );
+            s_errorTitle = "Couldn't convert sample rate!";
+            s_errorInfo = src_strerror( errorCode );
+            isSuccessful = false;
+            break;
+        }
+
+        srcData.data_in += srcData.input_frames_used * numChans;
+        srcData.input_frames -= srcData.input_frames_used;
+
+        const int numFramesToWrite = (int) jmin( (int64) srcData.output_frames_gen, totalNumOutputFrames - numOutputFramesWritten );
+
+        // The converter has been flushed
+        if ( numFramesToWrite == 0 && srcData.end_of_input && srcData.input_frames == 0 )
+        {
+            break;
         }
 
-        numSamplesWritten = sf_write_float( fileID, tempBuffer.getRawDataPointer(), numSamplesToWrite );
+        const int numSamplesWritten = sf_write_float( fileID, outputBuffer.getRawDataPointer(), numFramesToWrite * numChans );
 
-        if ( numSamplesWritten != numSamplesToWrite )
+        if ( numSamplesWritten != numFramesToWrite * numChans )
         {
-            sndfileRecordWriteError( numSamplesToWrite, numSamplesWritten );
+            sndfileRecordWriteError( numFramesToWrite * numChans, numSamplesWritten );
             isSuccessful = false;
         }
 
-        startSample += hopSize;
+        numOutputFramesWritten += numFramesToWrite;
     }
-    while ( numSamplesToWrite == hopSize && isSuccessful );
+
+    src_delete( srcState );
 
     return isSuccessful;
 }
@@ -424,6 +867,132 @@ void AudioFileHandler::sndfileRecordWriteError( const int numSamplesToWrite, con
 
 
 
+sf_count_t AudioFileHandler::sndfileGetMemoryLength( void* const userData )
+{
+    return (sf_count_t) static_cast<MemoryOutputStream*>( userData )->getDataSize();
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileSeekMemory( const sf_count_t offset, const int whence, void* const userData )
+{
+    MemoryOutputStream* const memory = static_cast<MemoryOutputStream*>( userData );
+
+    sf_count_t newPosition = offset;
+
+    switch ( whence )
+    {
+    case SEEK_CUR:
+        newPosition += memory->getPosition();
+        break;
+    case SEEK_END:
+        newPosition += memory->getDataSize();
+        break;
+    default:
+        break;
+    }
+
+    memory->setPosition( newPosition );
+
+    return memory->getPosition();
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileReadMemory( void* const data, const sf_count_t numBytes, void* const userData )
+{
+    MemoryOutputStream* const memory = static_cast<MemoryOutputStream*>( userData );
+
+    const sf_count_t position = memory->getPosition();
+    const sf_count_t numBytesToRead = jlimit( (sf_count_t) 0, numBytes, (sf_count_t) memory->getDataSize() - position );
+
+    memcpy( data, static_cast<const char*>( memory->getData() ) + position, (size_t) numBytesToRead );
+    memory->setPosition( position + numBytesToRead );
+
+    return numBytesToRead;
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileWriteMemory( const void* const data, const sf_count_t numBytes, void* const userData )
+{
+    return static_cast<MemoryOutputStream*>( userData )->write( data, (size_t) numBytes ) ? numBytes : 0;
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileTellMemory( void* const userData )
+{
+    return static_cast<MemoryOutputStream*>( userData )->getPosition();
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileGetStreamLength( void* const userData )
+{
+    return (sf_count_t) static_cast<LazyInputStream*>( userData )->stream->getTotalLength();
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileSeekStream( const sf_count_t offset, const int whence, void* const userData )
+{
+    LazyInputStream* const input = static_cast<LazyInputStream*>( userData );
+
+    sf_count_t newPosition = offset;
+
+    switch ( whence )
+    {
+    case SEEK_CUR:
+        newPosition += input->position;
+        break;
+    case SEEK_END:
+        newPosition += input->stream->getTotalLength();
+        break;
+    default:
+        break;
+    }
+
+    // The stream itself is only moved when data is next read from it
+    input->position = jlimit( (sf_count_t) 0, (sf_count_t) input->stream->getTotalLength(), newPosition );
+
+    return input->position;
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileReadStream( void* const data, const sf_count_t numBytes, void* const userData )
+{
+    LazyInputStream* const input = static_cast<LazyInputStream*>( userData );
+
+    if ( input->stream->getPosition() != input->position && ! input->stream->setPosition( input->position ) )
+    {
+        return 0;
+    }
+
+    const int numBytesRead = input->stream->read( data, (int) jmin( numBytes, (sf_count_t) std::numeric_limits<int>::max() ) );
+
+    input->position = input->stream->getPosition();
+
+    return jmax( numBytesRead, 0 );
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileWriteStream( const void* const, const sf_count_t, void* const )
+{
+    return 0;
+}
+
+
+
+sf_count_t AudioFileHandler::sndfileTellStream( void* const userData )
+{
+    return static_cast<LazyInputStream*>( userData )->position;
+}
+
+
+
 SharedSampleBuffer AudioFileHandler::sndfileLoadFile( const char* filePath, sf_count_t startFrame, sf_count_t numFramesToRead )
 {
     const sf_count_t hopSize = 4096;
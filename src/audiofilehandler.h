@@ -48,6 +48,54 @@ public:
                            int sndFileFormat,
                            bool isOverwriteEnabled = true );
 
+    // Encode "sampleBuffer" into "fileData", exactly as saveAudioFile() would write it to disk
+    bool encodeAudioData( SharedSampleBuffer sampleBuffer,
+                          int currentSampleRate,
+                          int outputSampleRate,
+                          int sndFileFormat,
+                          MemoryBlock& fileData );
+
+    // Write "sampleBuffer" to "stream" as a 32-bit float WAV file in a single pass, without seeking.
+    // "fileHash" is set to the hash of the bytes written, for use with savePeakStream()
+    bool saveAudioStream( OutputStream& stream,
+                          SharedSampleBuffer sampleBuffer,
+                          int sampleRate,
+                          QByteArray& fileHash );
+
+    // Write "sampleBuffer" to "stream" as a 24-bit FLAC file. Samples beyond full scale are clipped
+    bool saveFlacStream( OutputStream& stream,
+                         SharedSampleBuffer sampleBuffer,
+                         int sampleRate,
+                         QByteArray& fileHash );
+
+    // Write the peaks of "sampleBuffer" to "stream" for the audio file with hash "audioFileHash". The peaks are stored
+    // with the audio file's hash so that they are only used with the same audio data
+    bool savePeakStream( OutputStream& stream, QByteArray audioFileHash, SharedSampleBuffer sampleBuffer );
+
+    // Returns the extension, including the dot, given to audio files of type "sndFileFormat"
+    static QString getFileExtension( int sndFileFormat );
+
+    // Read only the header of an audio file, such as an entry in a project file, and set "sampleHeader" to its
+    // header info. Returns a silent placeholder of the file's size for decodeAudioData() to fill in later,
+    // or a null pointer if the header can't be read
+    static SharedSampleBuffer readAudioHeader( InputStream& stream, SharedSampleHeader& sampleHeader );
+
+    // Decode an audio file held in memory into a placeholder returned by readAudioHeader() for the same file.
+    // Returns false if the data can't be decoded. No error is recorded, so unlike the functions above this
+    // can safely be called from any thread
+    static bool decodeAudioData( MemoryBlock& fileData, SharedSampleBuffer sampleBuffer );
+
+    // Give "sampleBuffer" the peaks read from "stream", which must match the audio file with hash "audioFileHash".
+    // Returns false if they don't match, in which case the peaks are built from the sample data as usual.
+    // Safe to call from any thread while "sampleBuffer" isn't shared, or is a placeholder that hasn't been loaded yet
+    static bool loadPeakStream( InputStream& stream, QByteArray audioFileHash, SharedSampleBuffer sampleBuffer );
+
+    // How the audio of each sample buffer is stored in a project file
+    enum ProjectStorage { STORE_WAV_UNCOMPRESSED = 0, STORE_WAV_FAST = 1, STORE_WAV_SMALLEST = 2, STORE_FLAC = 3 };
+
+    // Returns the zip compression level that audio files should be added to a project file with
+    static int getCompressionLevel( ProjectStorage storage );
+
     QString getLastErrorTitle() const   { return s_errorTitle; }
     QString getLastErrorInfo() const    { return s_errorInfo; }
 
@@ -68,15 +116,36 @@ private:
                                      int numFrames,
                                      SharedSampleBuffer outputBuffer );
 
-    // Takes a buffer of non-interleaved samples, converts sample rate,
-    // and outputs a buffer of interleaved samples
-    static bool convertSampleRate( SharedSampleBuffer inputBuffer,
-                                   qreal sampleRateRatio,
-                                   Array<float>& outputBuffer );
+    // If the file is PCM and clipping has been enabled with SFC_SET_CLIPPING then "clippedPcmBitDepth" may be set to
+    // its bit depth; the samples are then rounded and clipped to that depth here, rather than by libsndfile
+    static bool sndfileSaveAudioFile( SNDFILE* fileID, SharedSampleBuffer sampleBuffer, int hopSize, int clippedPcmBitDepth = 0 );
+
+    // Converts the sample rate of "sampleBuffer" by "sampleRateRatio" a hop at a time as it is written, so only
+    // one hop of interleaved input and output is ever held in memory
+    static bool sndfileSaveAudioFile( SNDFILE* fileID, SharedSampleBuffer sampleBuffer, qreal sampleRateRatio, int hopSize );
 
-    static bool sndfileSaveAudioFile( SNDFILE* fileID, SharedSampleBuffer sampleBuffer, int hopSize );
-    static bool sndfileSaveAudioFile( SNDFILE* fileID, Array<float> interleavedBuffer, int hopSize );
     static void sndfileRecordWriteError( int numSamplesToWrite, int numSamplesWritten );
+
+    // libsndfile virtual I/O over a MemoryOutputStream, used to encode to and decode from memory
+    static sf_count_t sndfileGetMemoryLength( void* userData );
+    static sf_count_t sndfileSeekMemory( sf_count_t offset, int whence, void* userData );
+    static sf_count_t sndfileReadMemory( void* data, sf_count_t numBytes, void* userData );
+    static sf_count_t sndfileWriteMemory( const void* data, sf_count_t numBytes, void* userData );
+    static sf_count_t sndfileTellMemory( void* userData );
+
+    // libsndfile virtual I/O over an InputStream, used to read headers. Seeks are only carried out when data is next
+    // read, so libsndfile skipping past the sample data to look for more chunks doesn't have to decompress it all
+    struct LazyInputStream
+    {
+        InputStream* stream;
+        int64 position;
+    };
+
+    static sf_count_t sndfileGetStreamLength( void* userData );
+    static sf_count_t sndfileSeekStream( sf_count_t offset, int whence, void* userData );
+    static sf_count_t sndfileReadStream( void* data, sf_count_t numBytes, void* userData );
+    static sf_count_t sndfileWriteStream( const void* data, sf_count_t numBytes, void* userData );
+    static sf_count_t sndfileTellStream( void* userData );
     static SharedSampleBuffer sndfileLoadFile( const char* filePath, sf_count_t startFrame, sf_count_t numFramesToRead );
 
     static int sndlibInit();
@@ -85,8 +154,9 @@ private:
 
     static SharedSampleBuffer aubioLoadFile( const char* filePath, uint_t startFrame, uint_t numFramesToRead );
 
-    static QString s_errorTitle;
-    static QString s_errorInfo;
+    // The last error is kept per thread so that files can be saved on several threads at once
+    static thread_local QString s_errorTitle;
+    static thread_local QString s_errorInfo;
 
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( AudioFileHandler );
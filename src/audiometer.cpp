@@ -0,0 +1,210 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "audiometer.h"
+#include "globals.h"
+
+
+//==================================================================================================
+// Public:
+
+AudioMeter::AudioMeter( AudioSource* const inputSource ) :
+    AudioSource(),
+    m_inputSource( inputSource ),
+    m_fifo( FIFO_SIZE ),
+    m_fifoBuffer( OutputChannels::MAX, FIFO_SIZE ),
+    m_numChans( 0 ),
+    m_sampleRate( 0.0 ),
+    m_numOutputPairs( 0 ),
+    m_peakLevels( OutputChannels::MAX / 2, true ),
+    m_rmsLevels( OutputChannels::MAX / 2, true ),
+    m_spectrumOutputPairNum( 0 ),
+    m_fft( FFT_ORDER, false ),
+    m_fftInput( FFT_SIZE, true ),
+    m_fftInputSize( 0 ),
+    m_fftData( FFT_SIZE * 2, true ),
+    m_window( FFT_SIZE ),
+    m_spectrum( FFT_SIZE / 2, true )
+{
+    m_fifoBuffer.clear();
+
+    // Hann window
+    for ( int i = 0; i < FFT_SIZE; i++ )
+    {
+        m_window[ i ] = (float) ( 0.5 - 0.5 * cos( 2.0 * double_Pi * i / ( FFT_SIZE - 1 ) ) );
+    }
+}
+
+
+
+void AudioMeter::update()
+{
+    const int numChans = m_numChans.get();
+
+    m_numOutputPairs = ( numChans + 1 ) / 2;
+
+    float peaks[ OutputChannels::MAX / 2 ] = {};
+    double sumsOfSquares[ OutputChannels::MAX / 2 ] = {};
+
+    int start1, size1, start2, size2;
+    m_fifo.prepareToRead( m_fifo.getNumReady(), start1, size1, start2, size2 );
+
+    const int numFrames = size1 + size2;
+
+    if ( numFrames > 0 )
+    {
+        measure( numChans, start1, size1, peaks, sumsOfSquares );
+        measure( numChans, start2, size2, peaks, sumsOfSquares );
+
+        m_fifo.finishedRead( numFrames );
+
+        for ( int pairNum = 0; pairNum < m_numOutputPairs; pairNum++ )
+        {
+            const int numChansInPair = jmin( 2, numChans - pairNum * 2 );
+
+            m_peakLevels[ pairNum ] = peaks[ pairNum ];
+            m_rmsLevels[ pairNum ] = (float) sqrt( sumsOfSquares[ pairNum ] / ( numFrames * numChansInPair ) );
+        }
+    }
+}
+
+
+
+void AudioMeter::setSpectrumOutputPair( const int outputPairNum )
+{
+    if ( outputPairNum != m_spectrumOutputPairNum )
+    {
+        m_spectrumOutputPairNum = outputPairNum;
+        m_fftInputSize = 0;
+
+        FloatVectorOperations::clear( m_spectrum, FFT_SIZE / 2 );
+    }
+}
+
+
+
+void AudioMeter::prepareToPlay( const int samplesPerBlockExpected, const double sampleRate )
+{
+    m_sampleRate = sampleRate;
+    m_inputSource->prepareToPlay( samplesPerBlockExpected, sampleRate );
+}
+
+
+
+void AudioMeter::releaseResources()
+{
+    m_inputSource->releaseResources();
+}
+
+
+
+void AudioMeter::getNextAudioBlock( const AudioSourceChannelInfo& info )
+{
+    m_inputSource->getNextAudioBlock( info );
+
+    const int numChans = jmin( info.buffer->getNumChannels(), m_fifoBuffer.getNumChannels() );
+
+    int start1, size1, start2, size2;
+    m_fifo.prepareToWrite( info.numSamples, start1, size1, start2, size2 );
+
+    // If the GUI isn't keeping up then skip this block rather than wait
+    if ( size1 + size2 < info.numSamples )
+    {
+        return;
+    }
+
+    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
+    {
+        const float* const samples = info.buffer->getReadPointer( chanNum, info.startSample );
+
+        FloatVectorOperations::copy( m_fifoBuffer.getWritePointer( chanNum, start1 ), samples, size1 );
+
+        if ( size2 > 0 )
+        {
+            FloatVectorOperations::copy( m_fifoBuffer.getWritePointer( chanNum, start2 ), samples + size1, size2 );
+        }
+    }
+
+    m_numChans = numChans;
+    m_fifo.finishedWrite( size1 + size2 );
+}
+
+
+
+//==================================================================================================
+// Private:
+
+void AudioMeter::measure( const int numChans, const int startFrame, const int numFrames, float* const peaks, double* const sumsOfSquares )
+{
+    if ( numFrames <= 0 )
+    {
+        return;
+    }
+
+    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
+    {
+        const float* const samples = m_fifoBuffer.getReadPointer( chanNum, startFrame );
+        const int pairNum = chanNum / 2;
+
+        const Range<float> minMax = FloatVectorOperations::findMinAndMax( samples, numFrames );
+
+        peaks[ pairNum ] = jmax( peaks[ pairNum ], -minMax.getStart(), minMax.getEnd() );
+
+        double sumOfSquares = 0.0;
+
+        for ( int i = 0; i < numFrames; i++ )
+        {
+            sumOfSquares += samples[ i ] * samples[ i ];
+        }
+
+        sumsOfSquares[ pairNum ] += sumOfSquares;
+    }
+
+    // Mix the chosen output pair down to mono and take its spectrum every FFT_SIZE frames
+    const int leftChanNum = m_spectrumOutputPairNum * 2;
+
+    if ( leftChanNum < numChans )
+    {
+        const int rightChanNum = ( leftChanNum + 1 < numChans ) ? leftChanNum + 1 : leftChanNum;
+
+        const float* const left = m_fifoBuffer.getReadPointer( leftChanNum, startFrame );
+        const float* const right = m_fifoBuffer.getReadPointer( rightChanNum, startFrame );
+
+        for ( int i = 0; i < numFrames; i++ )
+        {
+            m_fftInput[ m_fftInputSize++ ] = ( left[ i ] + right[ i ] ) * 0.5f;
+
+            if ( m_fftInputSize == FFT_SIZE )
+            {
+                FloatVectorOperations::multiply( m_fftData, m_fftInput, m_window, FFT_SIZE );
+                FloatVectorOperations::clear( m_fftData + FFT_SIZE, FFT_SIZE );
+
+                m_fft.performFrequencyOnlyForwardTransform( m_fftData );
+
+                // Scale so that a full-scale sine wave has a magnitude of about 1.0, allowing for the window's loss
+                FloatVectorOperations::multiply( m_spectrum, m_fftData, 4.0f / FFT_SIZE, FFT_SIZE / 2 );
+
+                m_fftInputSize = 0;
+            }
+        }
+    }
+}
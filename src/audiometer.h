@@ -0,0 +1,100 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef AUDIOMETER_H
+#define AUDIOMETER_H
+
+#include "JuceHeader.h"
+
+
+// Passes through the output of another audio source, copying each block into a wait-free ring buffer.
+// The GUI thread calls update() to drain the ring buffer and measure the peak and RMS level of each output pair,
+// and the spectrum of one chosen output pair. The audio thread never locks or allocates; if the GUI falls behind
+// then blocks that don't fit in the ring buffer are simply not metered
+
+class AudioMeter : public AudioSource
+{
+public:
+    // "inputSource" is not owned by the meter and must outlive it
+    AudioMeter( AudioSource* inputSource );
+
+    // GUI thread: measure the audio published since the last call
+    void update();
+
+    int getNumOutputPairs() const                   { return m_numOutputPairs; }
+
+    // Levels over the audio measured by the last call to update(), in the range 0.0 - 1.0 (or more if clipping)
+    float getPeakLevel( int outputPairNum ) const   { return m_peakLevels[ outputPairNum ]; }
+    float getRmsLevel( int outputPairNum ) const    { return m_rmsLevels[ outputPairNum ]; }
+
+    int getSpectrumOutputPair() const               { return m_spectrumOutputPairNum; }
+    void setSpectrumOutputPair( int outputPairNum );
+
+    // Magnitudes of the most recent spectrum, from DC up to half the sample rate
+    const float* getSpectrum() const                { return m_spectrum; }
+    int getSpectrumSize() const                     { return FFT_SIZE / 2; }
+
+    double getSampleRate() const                    { return m_sampleRate; }
+
+    // For JUCE use only!
+    void prepareToPlay( int samplesPerBlockExpected, double sampleRate ) override;
+    void releaseResources() override;
+    void getNextAudioBlock( const AudioSourceChannelInfo& info ) override;
+
+    // Size of the ring buffer in frames
+    static const int FIFO_SIZE = 16384;
+
+    static const int FFT_ORDER = 11;
+    static const int FFT_SIZE = 1 << FFT_ORDER;
+
+private:
+    // Add 'numFrames' frames starting at 'startFrame' in the ring buffer to the level and spectrum measurements
+    void measure( int numChans, int startFrame, int numFrames, float* peaks, double* sumsOfSquares );
+
+    AudioSource* const m_inputSource;
+
+    AbstractFifo m_fifo;
+    AudioSampleBuffer m_fifoBuffer;
+
+    // No. of channels in the audio written to the ring buffer, set by the audio thread
+    Atomic<int> m_numChans;
+
+    volatile double m_sampleRate;
+
+    // The remaining members are only accessed by the GUI thread
+    int m_numOutputPairs;
+    HeapBlock<float> m_peakLevels;
+    HeapBlock<float> m_rmsLevels;
+
+    int m_spectrumOutputPairNum;
+    const FFT m_fft;
+    HeapBlock<float> m_fftInput;
+    int m_fftInputSize;
+    HeapBlock<float> m_fftData;
+    HeapBlock<float> m_window;
+    HeapBlock<float> m_spectrum;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( AudioMeter )
+};
+
+
+#endif // AUDIOMETER_H
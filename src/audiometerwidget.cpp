@@ -0,0 +1,238 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "audiometerwidget.h"
+#include <QPainter>
+#include <QMouseEvent>
+
+
+//==================================================================================================
+// Public:
+
+AudioMeterWidget::AudioMeterWidget( QWidget* parent ) :
+    QWidget( parent ),
+    m_audioMeter( NULL )
+{
+    m_timer.setInterval( UPDATE_INTERVAL );
+
+    connect( &m_timer, SIGNAL( timeout() ),
+             this, SLOT( updateLevels() ) );
+}
+
+
+
+void AudioMeterWidget::setAudioMeter( AudioMeter* const audioMeter )
+{
+    m_audioMeter = audioMeter;
+
+    m_peakLevels.clear();
+    m_rmsLevels.clear();
+
+    update();
+}
+
+
+
+QSize AudioMeterWidget::sizeHint() const
+{
+    return QSize( 480, 160 );
+}
+
+
+
+//==================================================================================================
+// Protected:
+
+void AudioMeterWidget::paintEvent( QPaintEvent* /*event*/ )
+{
+    QPainter painter( this );
+
+    painter.fillRect( rect(), Qt::black );
+
+    // Level bars
+    const int spectrumOutputPairNum = ( m_audioMeter != NULL ) ? m_audioMeter->getSpectrumOutputPair() : -1;
+
+    for ( int pairNum = 0; pairNum < m_peakLevels.size(); pairNum++ )
+    {
+        const QRect barRect = getLevelBarRect( pairNum );
+
+        painter.fillRect( barRect, QColor( 40, 40, 40 ) );
+
+        const int rmsHeight = roundToInt( getProportionOfRange( m_rmsLevels.at( pairNum ), MIN_DECIBELS ) * barRect.height() );
+
+        painter.fillRect( barRect.left(), barRect.bottom() - rmsHeight + 1, barRect.width(), rmsHeight, QColor( 0, 192, 0 ) );
+
+        const int peakY = barRect.bottom() - roundToInt( getProportionOfRange( m_peakLevels.at( pairNum ), MIN_DECIBELS ) * barRect.height() );
+
+        painter.setPen( m_peakLevels.at( pairNum ) >= 1.0f ? Qt::red : Qt::yellow );
+        painter.drawLine( barRect.left(), peakY, barRect.right(), peakY );
+
+        if ( pairNum == spectrumOutputPairNum )
+        {
+            painter.setPen( Qt::white );
+            painter.drawRect( barRect.adjusted( -1, -1, 0, 0 ) );
+        }
+
+        painter.setPen( Qt::lightGray );
+        painter.drawText( QRect( barRect.left() - BAR_SPACING / 2, barRect.bottom() + 1, BAR_WIDTH + BAR_SPACING, LABEL_HEIGHT ),
+                          Qt::AlignCenter,
+                          QString( "%1-%2" ).arg( pairNum * 2 + 1 ).arg( pairNum * 2 + 2 ) );
+    }
+
+    // Spectrum, with a logarithmic frequency scale
+    const QRect spectrumRect = getSpectrumRect();
+
+    painter.setPen( QColor( 60, 60, 60 ) );
+    painter.drawRect( spectrumRect );
+
+    if ( m_audioMeter != NULL && m_audioMeter->getSampleRate() > 0.0 && ! m_peakLevels.isEmpty() )
+    {
+        const float* const spectrum = m_audioMeter->getSpectrum();
+        const int numBins = m_audioMeter->getSpectrumSize();
+
+        const qreal nyquist = m_audioMeter->getSampleRate() / 2.0;
+        const qreal logRange = log( nyquist / MIN_SPECTRUM_FREQUENCY );
+
+        QPolygonF polyline;
+
+        for ( int binNum = 1; binNum < numBins; binNum++ )
+        {
+            const qreal frequency = binNum * nyquist / numBins;
+
+            if ( frequency >= MIN_SPECTRUM_FREQUENCY )
+            {
+                const qreal x = spectrumRect.left() + spectrumRect.width() * log( frequency / MIN_SPECTRUM_FREQUENCY ) / logRange;
+                const qreal y = spectrumRect.bottom() - getProportionOfRange( spectrum[ binNum ], MIN_SPECTRUM_DECIBELS ) * spectrumRect.height();
+
+                polyline << QPointF( x, y );
+            }
+        }
+
+        painter.setRenderHint( QPainter::Antialiasing, true );
+        painter.setPen( Qt::cyan );
+        painter.drawPolyline( polyline );
+    }
+}
+
+
+
+void AudioMeterWidget::mousePressEvent( QMouseEvent* event )
+{
+    if ( m_audioMeter != NULL )
+    {
+        for ( int pairNum = 0; pairNum < m_peakLevels.size(); pairNum++ )
+        {
+            if ( getLevelBarRect( pairNum ).contains( event->pos() ) )
+            {
+                m_audioMeter->setSpectrumOutputPair( pairNum );
+                update();
+                break;
+            }
+        }
+    }
+
+    QWidget::mousePressEvent( event );
+}
+
+
+
+void AudioMeterWidget::showEvent( QShowEvent* event )
+{
+    m_timer.start();
+
+    QWidget::showEvent( event );
+}
+
+
+
+void AudioMeterWidget::hideEvent( QHideEvent* event )
+{
+    m_timer.stop();
+
+    QWidget::hideEvent( event );
+}
+
+
+
+//==================================================================================================
+// Private:
+
+QRect AudioMeterWidget::getLevelBarRect( const int outputPairNum ) const
+{
+    return QRect( MARGIN + outputPairNum * ( BAR_WIDTH + BAR_SPACING ),
+                  MARGIN,
+                  BAR_WIDTH,
+                  height() - MARGIN * 2 - LABEL_HEIGHT );
+}
+
+
+
+QRect AudioMeterWidget::getSpectrumRect() const
+{
+    const int left = MARGIN * 2 + m_peakLevels.size() * ( BAR_WIDTH + BAR_SPACING );
+
+    return QRect( left, MARGIN, width() - left - MARGIN, height() - MARGIN * 2 - LABEL_HEIGHT );
+}
+
+
+
+//==================================================================================================
+// Private Static:
+
+qreal AudioMeterWidget::getProportionOfRange( const float gain, const int minDecibels )
+{
+    const float decibels = Decibels::gainToDecibels( gain, (float) minDecibels );
+
+    return jlimit( 0.0, 1.0, ( decibels - minDecibels ) / (qreal) -minDecibels );
+}
+
+
+
+//==================================================================================================
+// Private Slots:
+
+void AudioMeterWidget::updateLevels()
+{
+    if ( m_audioMeter == NULL )
+    {
+        return;
+    }
+
+    m_audioMeter->update();
+
+    const int numOutputPairs = m_audioMeter->getNumOutputPairs();
+
+    if ( numOutputPairs != m_peakLevels.size() )
+    {
+        m_peakLevels.fill( 0.0f, numOutputPairs );
+        m_rmsLevels.fill( 0.0f, numOutputPairs );
+    }
+
+    // Rise instantly but fall back gradually so that the meters are readable
+    for ( int pairNum = 0; pairNum < numOutputPairs; pairNum++ )
+    {
+        m_peakLevels[ pairNum ] = qMax( m_audioMeter->getPeakLevel( pairNum ), m_peakLevels.at( pairNum ) * 0.85f );
+        m_rmsLevels[ pairNum ] = qMax( m_audioMeter->getRmsLevel( pairNum ), m_rmsLevels.at( pairNum ) * 0.85f );
+    }
+
+    update();
+}
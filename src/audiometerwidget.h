@@ -0,0 +1,88 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef AUDIOMETERWIDGET_H
+#define AUDIOMETERWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QVector>
+#include "JuceHeader.h"
+#include "audiometer.h"
+
+
+// Shows the peak and RMS level of each output pair as a bar, and the spectrum of the selected output pair.
+// Clicking on a bar selects its output pair for the spectrum
+
+class AudioMeterWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    AudioMeterWidget( QWidget* parent = NULL );
+
+    // Pass NULL to stop metering, e.g. before the audio meter is deleted
+    void setAudioMeter( AudioMeter* audioMeter );
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent( QPaintEvent* event );
+    void mousePressEvent( QMouseEvent* event );
+    void showEvent( QShowEvent* event );
+    void hideEvent( QHideEvent* event );
+
+private:
+    QRect getLevelBarRect( int outputPairNum ) const;
+    QRect getSpectrumRect() const;
+
+    AudioMeter* m_audioMeter;
+
+    QTimer m_timer;
+
+    // Levels as displayed, falling back gradually after a peak
+    QVector<float> m_peakLevels;
+    QVector<float> m_rmsLevels;
+
+    static const int UPDATE_INTERVAL = 33;  // Milliseconds
+    static const int MIN_DECIBELS = -60;
+    static const int MIN_SPECTRUM_DECIBELS = -90;
+    static const int MIN_SPECTRUM_FREQUENCY = 20;
+
+    static const int BAR_WIDTH = 16;
+    static const int BAR_SPACING = 6;
+    static const int LABEL_HEIGHT = 16;
+    static const int MARGIN = 6;
+
+private:
+    // Returns where 'gain' lies between 'minDecibels' and 0 dB, in the range 0.0 - 1.0
+    static qreal getProportionOfRange( float gain, int minDecibels );
+
+private slots:
+    void updateLevels();
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( AudioMeterWidget );
+};
+
+
+#endif // AUDIOMETERWIDGET_H
@@ -0,0 +1,200 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Times the SampleKernels against the plain loops they replaced, and checks that both give the same output.
+// Built on its own by samplekernelsbenchmark.pro; it isn't part of Shuriken
+
+#include "samplekernels.h"
+#include <cstdio>
+
+
+//==================================================================================================
+// The loops that the kernels replaced
+
+static void interleaveOld( const float* const* const input, const int numChans, const int numFrames, Array<float>& output )
+{
+    for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+    {
+        const float* sampleData = input[ chanNum ];
+
+        for ( int frameNum = 0; frameNum < numFrames; ++frameNum )
+        {
+            output.set( numChans * frameNum + chanNum,    // Index
+                        sampleData[ frameNum ] );         // Value
+        }
+    }
+}
+
+
+
+static void deinterleaveOld( const float* const input, const int numChans, const int numFrames, float* const* const output )
+{
+    for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+    {
+        float* outputSampleData = output[ chanNum ];
+
+        for ( int frameNum = 0; frameNum < numFrames; ++frameNum )
+        {
+            outputSampleData[ frameNum ] = input[ numChans * frameNum + chanNum ];
+        }
+    }
+}
+
+
+
+// libsndfile's conversion of floats to clipped 24-bit FLAC samples, which was used before
+// floatToPcmClipped(), shifted to the top of a 32-bit int for comparison
+static void floatToPcm24ClippedOld( const float* const input, const int numSamples, int* const output )
+{
+    const float normFactor = 8.0f * 0x100000;
+
+    for ( int i = 0; i < numSamples; ++i )
+    {
+        const float scaledValue = input[ i ] * normFactor;
+
+        int value;
+
+        if ( scaledValue >= 1.0f * 0x7FFFFF )
+            value = 0x7FFFFF;
+        else if ( scaledValue <= -8.0f * 0x100000 )
+            value = -0x800000;
+        else
+            value = (int) lrintf( scaledValue );
+
+        output[ i ] = (int) ( (uint32) value << 8 );
+    }
+}
+
+
+
+//==================================================================================================
+
+static const int NUM_FRAMES = 8192;     // The hop size used when reading and writing audio files
+static const int NUM_REPEATS = 2000;
+
+
+
+// Returns the throughput in MB of input floats per second
+template <typename Function>
+static double timeFunction( const int numChans, Function function )
+{
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    for ( int i = 0; i < NUM_REPEATS; ++i )
+    {
+        function();
+    }
+
+    const double secs = Time::highResolutionTicksToSeconds( Time::getHighResolutionTicks() - startTicks );
+    const double numBytes = (double) NUM_REPEATS * NUM_FRAMES * numChans * sizeof( float );
+
+    return numBytes / ( 1024.0 * 1024.0 ) / secs;
+}
+
+
+
+static void printResult( const char* const name, const double oldMBPerSec, const double newMBPerSec, const bool isIdentical )
+{
+    printf( "  %-24s %10.0f %12.0f %10.1fx   %s\n",
+            name, oldMBPerSec, newMBPerSec, newMBPerSec / oldMBPerSec, isIdentical ? "identical" : "MISMATCH" );
+}
+
+
+
+int main()
+{
+    Random random( 1 );
+    bool isAllIdentical = true;
+
+    printf( "%d-frame hop repeated %d times\n\n", NUM_FRAMES, NUM_REPEATS );
+    printf( "  %-24s %10s %12s %11s\n", "", "old (MB/s)", "new (MB/s)", "speedup" );
+
+    for ( int numChans = 1; numChans <= 2; ++numChans )
+    {
+        HeapBlock<float> channelData( NUM_FRAMES * numChans );
+        HeapBlock<float> oldChannelData( NUM_FRAMES * numChans, true );
+        HeapBlock<float> newChannelData( NUM_FRAMES * numChans, true );
+        HeapBlock<float*> channels( numChans );
+        HeapBlock<float*> oldChannels( numChans );
+        HeapBlock<float*> newChannels( numChans );
+
+        for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+        {
+            channels[ chanNum ] = channelData + chanNum * NUM_FRAMES;
+            oldChannels[ chanNum ] = oldChannelData + chanNum * NUM_FRAMES;
+            newChannels[ chanNum ] = newChannelData + chanNum * NUM_FRAMES;
+        }
+
+        for ( int i = 0; i < NUM_FRAMES * numChans; ++i )
+        {
+            channelData[ i ] = random.nextFloat() * 2.0f - 1.0f;
+        }
+
+        Array<float> oldInterleaved;
+        oldInterleaved.resize( NUM_FRAMES * numChans );
+        HeapBlock<float> newInterleaved( NUM_FRAMES * numChans, true );
+
+        const float* const* const input = channels;
+
+        const double oldInterleaveRate = timeFunction( numChans, [&] { interleaveOld( input, numChans, NUM_FRAMES, oldInterleaved ); } );
+        const double newInterleaveRate = timeFunction( numChans, [&] { SampleKernels::interleave( input, numChans, NUM_FRAMES, newInterleaved ); } );
+
+        const bool isInterleaveIdentical = memcmp( oldInterleaved.getRawDataPointer(), newInterleaved,
+                                                   NUM_FRAMES * numChans * sizeof( float ) ) == 0;
+
+        const double oldDeinterleaveRate = timeFunction( numChans, [&] { deinterleaveOld( newInterleaved, numChans, NUM_FRAMES, oldChannels ); } );
+        const double newDeinterleaveRate = timeFunction( numChans, [&] { SampleKernels::deinterleave( newInterleaved, numChans, NUM_FRAMES, newChannels ); } );
+
+        const bool isDeinterleaveIdentical = memcmp( oldChannelData, newChannelData, NUM_FRAMES * numChans * sizeof( float ) ) == 0 &&
+                                             memcmp( channelData, newChannelData, NUM_FRAMES * numChans * sizeof( float ) ) == 0;
+
+        printResult( numChans == 1 ? "interleave mono" : "interleave stereo", oldInterleaveRate, newInterleaveRate, isInterleaveIdentical );
+        printResult( numChans == 1 ? "deinterleave mono" : "deinterleave stereo", oldDeinterleaveRate, newDeinterleaveRate, isDeinterleaveIdentical );
+
+        isAllIdentical = isAllIdentical && isInterleaveIdentical && isDeinterleaveIdentical;
+    }
+
+    // Include samples beyond full scale so that clipping is exercised
+    {
+        const int numSamples = NUM_FRAMES * 2;
+
+        HeapBlock<float> samples( numSamples );
+        HeapBlock<int> oldPcm( numSamples, true );
+        HeapBlock<int> newPcm( numSamples, true );
+
+        for ( int i = 0; i < numSamples; ++i )
+        {
+            samples[ i ] = random.nextFloat() * 2.4f - 1.2f;
+        }
+
+        const double oldRate = timeFunction( 2, [&] { floatToPcm24ClippedOld( samples, numSamples, oldPcm ); } );
+        const double newRate = timeFunction( 2, [&] { SampleKernels::floatToPcmClipped( samples, numSamples, 24, newPcm ); } );
+
+        const bool isIdentical = memcmp( oldPcm, newPcm, numSamples * sizeof( int ) ) == 0;
+
+        printResult( "float->24-bit clipped", oldRate, newRate, isIdentical );
+
+        isAllIdentical = isAllIdentical && isIdentical;
+    }
+
+    return isAllIdentical ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+# -------------------------------------------------
+# Microbenchmark of the SampleKernels against the loops they replaced
+#
+#   qmake samplekernelsbenchmark.pro && make && ./samplekernelsbenchmark
+#
+# Build in release mode; the exit status is non-zero if any kernel's output differs
+# -------------------------------------------------
+QMAKE_CXXFLAGS += -msse \
+    -msse2 \
+    -std=c++11
+# The JUCE config includes globals.h, which needs QtGui
+QT += opengl
+TARGET = samplekernelsbenchmark
+TEMPLATE = app
+CONFIG += console \
+    release
+CONFIG -= debug \
+    app_bundle
+SOURCES += samplekernelsbenchmark.cpp \
+    ../samplekernels.cpp \
+    ../JuceLibraryCode/modules/juce_core/juce_core.cpp
+HEADERS += ../samplekernels.h
+INCLUDEPATH += .. \
+    ../JuceLibraryCode
+LIBS += -ldl \
+    -lpthread \
+    -lrt
+unix:DEFINES += "LINUX=1"
+DEFINES += "NDEBUG=1"
@@ -247,10 +247,9 @@ void SliceCommand::undo()
 
     m_mainWindow->stopPlayback();
 
-    SharedSampleBuffer singleBuffer = SampleUtils::joinSampleBuffers( m_mainWindow->m_sampleBufferList );
-
-    m_mainWindow->m_sampleBufferList.clear();
-    m_mainWindow->m_sampleBufferList << singleBuffer;
+    // Restore the original sample buffer, along with any non-destructive edits it had
+    m_mainWindow->m_sampleBufferList = m_origSampleBufferList;
+    m_origSampleBufferList.clear();
 
     m_mainWindow->m_samplerAudioSource->setSamples( m_mainWindow->m_sampleBufferList,
                                                     m_mainWindow->m_sampleHeader->sampleRate );
@@ -279,6 +278,8 @@ void SliceCommand::redo()
 
     m_mainWindow->stopPlayback();
 
+    m_origSampleBufferList = m_mainWindow->m_sampleBufferList;
+
     m_mainWindow->m_sampleBufferList = SampleUtils::splitSampleBuffer( m_mainWindow->m_sampleBufferList.first(),
                                                                        m_graphicsScene->getSlicePointFrameNums() );
 
@@ -345,8 +346,9 @@ void UnsliceCommand::undo()
 
     m_mainWindow->stopPlayback();
 
-    m_mainWindow->m_sampleBufferList = SampleUtils::splitSampleBuffer( m_mainWindow->m_sampleBufferList.first(),
-                                                                       m_graphicsScene->getSlicePointFrameNums() );
+    // Restore the original sample buffers, along with any non-destructive edits they had
+    m_mainWindow->m_sampleBufferList = m_origSampleBufferList;
+    m_origSampleBufferList.clear();
 
     m_mainWindow->m_samplerAudioSource->setSamples( m_mainWindow->m_sampleBufferList,
                                                     m_mainWindow->m_sampleHeader->sampleRate );
@@ -383,6 +385,8 @@ void UnsliceCommand::redo()
 
     m_mainWindow->stopPlayback();
 
+    m_origSampleBufferList = m_mainWindow->m_sampleBufferList;
+
     SharedSampleBuffer singleBuffer = SampleUtils::joinSampleBuffers( m_mainWindow->m_sampleBufferList );
 
     m_mainWindow->m_sampleBufferList.clear();
@@ -860,7 +864,6 @@ PasteWaveformItemCommand::PasteWaveformItemCommand( const QList<SharedSampleBuff
                                                     MainWindow* const mainWindow,
                                                     QUndoCommand* parent ) :
     QUndoCommand( parent ),
-    m_copiedSampleBuffers( copiedSampleBuffers ),
     m_copiedEnvelopes( copiedEnvelopes ),
     m_copiedNoteTimeRatios( copiedNoteTimeRatios ),
     m_orderPosToInsertAt( orderPosToInsertAt ),
@@ -868,6 +871,13 @@ PasteWaveformItemCommand::PasteWaveformItemCommand( const QList<SharedSampleBuff
     m_mainWindow( mainWindow )
 {
     setText( "Paste Waveform" );
+
+    // Each paste gets its own sample buffers so that edits made to one pasted waveform don't affect
+    // another, but the sample data itself stays shared with the clipboard until it's modified
+    foreach ( SharedSampleBuffer sampleBuffer, copiedSampleBuffers )
+    {
+        m_copiedSampleBuffers << SampleUtils::createSharedCopy( sampleBuffer );
+    }
 }
 
 
@@ -1026,20 +1036,14 @@ void PasteWaveformItemCommand::redo()
 
 ApplyGainCommand::ApplyGainCommand( const float gain,
                                     const int waveformItemOrderPos,
+                                    MainWindow* const mainWindow,
                                     WaveGraphicsScene* const graphicsScene,
-                                    const int sampleRate,
-                                    AudioFileHandler& fileHandler,
-                                    const QString tempDirPath,
-                                    const QString fileBaseName,
                                     QUndoCommand* parent ) :
     QUndoCommand( parent ),
     m_gain( gain ),
     m_orderPos( waveformItemOrderPos ),
-    m_graphicsScene( graphicsScene ),
-    m_sampleRate( sampleRate ),
-    m_fileHandler( fileHandler ),
-    m_tempDirPath( tempDirPath ),
-    m_fileBaseName( fileBaseName )
+    m_mainWindow( mainWindow ),
+    m_graphicsScene( graphicsScene )
 {
     setText( "Apply Gain" );
 }
@@ -1048,24 +1052,12 @@ ApplyGainCommand::ApplyGainCommand( const float gain,
 
 void ApplyGainCommand::undo()
 {
-    if ( ! m_filePath.isEmpty() )
-    {
-        const SharedWaveformItem waveformItem = m_graphicsScene->getWaveformAt( m_orderPos );
-
-        const SharedSampleBuffer origSampleBuffer = m_fileHandler.getSampleData( m_filePath );
-
-        const int numChans = origSampleBuffer->getNumChannels();
-        const int numFrames = origSampleBuffer->getNumFrames();
-
-        const SharedSampleBuffer sampleBuffer = waveformItem->getSampleBuffer();
+    const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
 
-        for ( int chanNum = 0; chanNum < numChans; chanNum++ )
-        {
-            sampleBuffer->copyFrom( chanNum, 0, *origSampleBuffer.data(), chanNum, 0, numFrames );
-        }
+    item->getSampleBuffer()->popEdit();
 
-        m_graphicsScene->redrawWaveforms();
-    }
+    m_mainWindow->resetSamples();
+    m_graphicsScene->redrawWaveforms();
 }
 
 
@@ -1073,24 +1065,11 @@ void ApplyGainCommand::undo()
 void ApplyGainCommand::redo()
 {
     const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
-    const SharedSampleBuffer sampleBuffer = item->getSampleBuffer();
 
-    m_filePath = m_fileHandler.saveAudioFile( m_tempDirPath,
-                                            m_fileBaseName,
-                                            sampleBuffer,
-                                            m_sampleRate,
-                                            m_sampleRate,
-                                            AudioFileHandler::TEMP_FORMAT );
+    item->getSampleBuffer()->pushEdit( SampleEdit( SampleEdit::GAIN, m_gain, m_gain ) );
 
-    if ( ! m_filePath.isEmpty() )
-    {
-        sampleBuffer->applyGain( 0, sampleBuffer->getNumFrames(), m_gain );
-        m_graphicsScene->redrawWaveforms();
-    }
-    else
-    {
-        MessageBoxes::showWarningDialog( m_fileHandler.getLastErrorTitle(), m_fileHandler.getLastErrorInfo() );
-    }
+    m_mainWindow->resetSamples();
+    m_graphicsScene->redrawWaveforms();
 }
 
 
@@ -1100,21 +1079,15 @@ void ApplyGainCommand::redo()
 ApplyGainRampCommand::ApplyGainRampCommand( const float startGain,
                                             const float endGain,
                                             const int waveformItemOrderPos,
+                                            MainWindow* const mainWindow,
                                             WaveGraphicsScene* const graphicsScene,
-                                            const int sampleRate,
-                                            AudioFileHandler& fileHandler,
-                                            const QString tempDirPath,
-                                            const QString fileBaseName,
                                             QUndoCommand* parent ) :
     QUndoCommand( parent ),
     m_startGain( startGain ),
     m_endGain( endGain ),
     m_orderPos( waveformItemOrderPos ),
-    m_graphicsScene( graphicsScene ),
-    m_sampleRate( sampleRate ),
-    m_fileHandler( fileHandler ),
-    m_tempDirPath( tempDirPath ),
-    m_fileBaseName( fileBaseName )
+    m_mainWindow( mainWindow ),
+    m_graphicsScene( graphicsScene )
 {
     setText( "Apply Gain Ramp" );
 }
@@ -1123,24 +1096,12 @@ ApplyGainRampCommand::ApplyGainRampCommand( const float startGain,
 
 void ApplyGainRampCommand::undo()
 {
-    if ( ! m_filePath.isEmpty() )
-    {
-        const SharedWaveformItem waveformItem = m_graphicsScene->getWaveformAt( m_orderPos );
-
-        const SharedSampleBuffer origSampleBuffer = m_fileHandler.getSampleData( m_filePath );
-
-        const int numChans = origSampleBuffer->getNumChannels();
-        const int numFrames = origSampleBuffer->getNumFrames();
-
-        const SharedSampleBuffer sampleBuffer = waveformItem->getSampleBuffer();
+    const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
 
-        for ( int chanNum = 0; chanNum < numChans; chanNum++ )
-        {
-            sampleBuffer->copyFrom( chanNum, 0, *origSampleBuffer.data(), chanNum, 0, numFrames );
-        }
+    item->getSampleBuffer()->popEdit();
 
-        m_graphicsScene->redrawWaveforms();
-    }
+    m_mainWindow->resetSamples();
+    m_graphicsScene->redrawWaveforms();
 }
 
 
@@ -1148,24 +1109,11 @@ void ApplyGainRampCommand::undo()
 void ApplyGainRampCommand::redo()
 {
     const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
-    const SharedSampleBuffer sampleBuffer = item->getSampleBuffer();
 
-    m_filePath = m_fileHandler.saveAudioFile( m_tempDirPath,
-                                            m_fileBaseName,
-                                            sampleBuffer,
-                                            m_sampleRate,
-                                            m_sampleRate,
-                                            AudioFileHandler::TEMP_FORMAT );
+    item->getSampleBuffer()->pushEdit( SampleEdit( SampleEdit::GAIN_RAMP, m_startGain, m_endGain ) );
 
-    if ( ! m_filePath.isEmpty() )
-    {
-        sampleBuffer->applyGainRamp( 0, sampleBuffer->getNumFrames(), m_startGain, m_endGain );
-        m_graphicsScene->redrawWaveforms();
-    }
-    else
-    {
-        MessageBoxes::showWarningDialog( m_fileHandler.getLastErrorTitle(), m_fileHandler.getLastErrorInfo() );
-    }
+    m_mainWindow->resetSamples();
+    m_graphicsScene->redrawWaveforms();
 }
 
 
@@ -1173,19 +1121,14 @@ void ApplyGainRampCommand::redo()
 //==================================================================================================
 
 NormaliseCommand::NormaliseCommand( const int waveformItemOrderPos,
+                                    MainWindow* const mainWindow,
                                     WaveGraphicsScene* const graphicsScene,
-                                    const int sampleRate,
-                                    AudioFileHandler& fileHandler,
-                                    const QString tempDirPath,
-                                    const QString fileBaseName,
                                     QUndoCommand* parent ) :
     QUndoCommand( parent ),
     m_orderPos( waveformItemOrderPos ),
+    m_mainWindow( mainWindow ),
     m_graphicsScene( graphicsScene ),
-    m_sampleRate( sampleRate ),
-    m_fileHandler( fileHandler ),
-    m_tempDirPath( tempDirPath ),
-    m_fileBaseName( fileBaseName )
+    m_isEditPushed( false )
 {
     setText( "Normalise" );
 }
@@ -1194,22 +1137,14 @@ NormaliseCommand::NormaliseCommand( const int waveformItemOrderPos,
 
 void NormaliseCommand::undo()
 {
-    if ( ! m_filePath.isEmpty() )
+    if ( m_isEditPushed )
     {
-        const SharedWaveformItem waveformItem = m_graphicsScene->getWaveformAt( m_orderPos );
-
-        const SharedSampleBuffer origSampleBuffer = m_fileHandler.getSampleData( m_filePath );
+        const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
 
-        const int numChans = origSampleBuffer->getNumChannels();
-        const int numFrames = origSampleBuffer->getNumFrames();
-
-        const SharedSampleBuffer sampleBuffer = waveformItem->getSampleBuffer();
-
-        for ( int chanNum = 0; chanNum < numChans; chanNum++ )
-        {
-            sampleBuffer->copyFrom( chanNum, 0, *origSampleBuffer.data(), chanNum, 0, numFrames );
-        }
+        item->getSampleBuffer()->popEdit();
+        m_isEditPushed = false;
 
+        m_mainWindow->resetSamples();
         m_graphicsScene->redrawWaveforms();
     }
 }
@@ -1221,27 +1156,18 @@ void NormaliseCommand::redo()
     const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
     const SharedSampleBuffer sampleBuffer = item->getSampleBuffer();
 
-    m_filePath = m_fileHandler.saveAudioFile( m_tempDirPath,
-                                            m_fileBaseName,
-                                            sampleBuffer,
-                                            m_sampleRate,
-                                            m_sampleRate,
-                                            AudioFileHandler::TEMP_FORMAT );
+    // The normalise factor depends on any edits already applied, so it is worked out afresh each time
+    const float magnitude = SampleUtils::getEditedMagnitude( sampleBuffer );
 
-    if ( ! m_filePath.isEmpty() )
+    if ( magnitude > 0.0f )
     {
-        const int numFrames = sampleBuffer->getNumFrames();
-        const float magnitude = sampleBuffer->getMagnitude( 0, numFrames );
+        const float gain = 1.0f / magnitude;
 
-        if ( magnitude > 0.0 )
-        {
-            sampleBuffer->applyGain( 0, numFrames, 1.0 / magnitude );
-            m_graphicsScene->redrawWaveforms();
-        }
-    }
-    else
-    {
-        MessageBoxes::showWarningDialog( m_fileHandler.getLastErrorTitle(), m_fileHandler.getLastErrorInfo() );
+        sampleBuffer->pushEdit( SampleEdit( SampleEdit::GAIN, gain, gain ) );
+        m_isEditPushed = true;
+
+        m_mainWindow->resetSamples();
+        m_graphicsScene->redrawWaveforms();
     }
 }
 
@@ -1250,10 +1176,12 @@ void NormaliseCommand::redo()
 //==================================================================================================
 
 ReverseCommand::ReverseCommand( const int waveformItemOrderPos,
+                                MainWindow* const mainWindow,
                                 WaveGraphicsScene* const graphicsScene,
                                 QUndoCommand* parent ) :
     QUndoCommand( parent ),
-    mOrderPos( waveformItemOrderPos ),
+    m_orderPos( waveformItemOrderPos ),
+    m_mainWindow( mainWindow ),
     m_graphicsScene( graphicsScene )
 {
     setText( "Reverse" );
@@ -1263,18 +1191,23 @@ ReverseCommand::ReverseCommand( const int waveformItemOrderPos,
 
 void ReverseCommand::undo()
 {
-    redo();
+    const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
+
+    item->getSampleBuffer()->popEdit();
+
+    m_mainWindow->resetSamples();
+    m_graphicsScene->redrawWaveforms();
 }
 
 
 
 void ReverseCommand::redo()
 {
-    const SharedWaveformItem item = m_graphicsScene->getWaveformAt( mOrderPos );
-    const SharedSampleBuffer sampleBuffer = item->getSampleBuffer();
+    const SharedWaveformItem item = m_graphicsScene->getWaveformAt( m_orderPos );
 
-    sampleBuffer->reverse( 0, sampleBuffer->getNumFrames() );
+    item->getSampleBuffer()->pushEdit( SampleEdit( SampleEdit::REVERSE ) );
 
+    m_mainWindow->resetSamples();
     m_graphicsScene->redrawWaveforms();
 }
 
@@ -1326,6 +1259,7 @@ void GlobalTimeStretchCommand::undo()
 
         const SharedSampleBuffer sampleBuffer = m_mainWindow->m_sampleBufferList.at( i );
         sampleBuffer->setSize( numChans, origBufferSize );
+        sampleBuffer->detach();
 
         for ( int chanNum = 0; chanNum < numChans; chanNum++ )
         {
@@ -1386,6 +1320,7 @@ void GlobalTimeStretchCommand::redo()
         const int sampleRate = m_mainWindow->m_sampleHeader->sampleRate;
         const int numChans = m_mainWindow->m_sampleHeader->numChans;
 
+        // Non-destructive edits are relative to the length of each buffer, so they still apply after stretching
         foreach ( SharedSampleBuffer sampleBuffer, m_mainWindow->m_sampleBufferList )
         {
             OfflineTimeStretcher::stretch( sampleBuffer, sampleRate, numChans, m_options, timeRatio, pitchScale );
@@ -1472,6 +1407,7 @@ void RenderTimeStretchCommand::undo()
 
         const SharedSampleBuffer sampleBuffer = m_mainWindow->m_sampleBufferList.at( i );
         sampleBuffer->setSize( numChans, origBufferSize );
+        sampleBuffer->detach();
 
         for ( int chanNum = 0; chanNum < numChans; chanNum++ )
         {
@@ -139,6 +139,7 @@ private:
     QAction* const m_selectMoveItemsAction;
     QAction* const m_auditionItemsAction;
     QAction* const m_selectiveTimeStretchAction;
+    QList<SharedSampleBuffer> m_origSampleBufferList;
 };
 
 
@@ -170,6 +171,7 @@ private:
     QAction* const m_selectMoveItemsAction;
     QAction* const m_auditionItemsAction;
     QAction* const m_selectiveTimeStretchAction;
+    QList<SharedSampleBuffer> m_origSampleBufferList;
 };
 
 
@@ -321,7 +323,7 @@ public:
     void redo();
 
 private:
-    const QList<SharedSampleBuffer> m_copiedSampleBuffers;
+    QList<SharedSampleBuffer> m_copiedSampleBuffers;
     const SamplerAudioSource::EnvelopeSettings m_copiedEnvelopes;
     const QList<qreal> m_copiedNoteTimeRatios;
     const int m_orderPosToInsertAt;
@@ -336,11 +338,8 @@ class ApplyGainCommand : public QUndoCommand
 public:
     ApplyGainCommand( float gain,
                       int waveformItemOrderPos,
+                      MainWindow* mainWindow,
                       WaveGraphicsScene* graphicsScene,
-                      int sampleRate,
-                      AudioFileHandler& fileHandler,
-                      QString tempDirPath,
-                      QString fileBaseName,
                       QUndoCommand* parent = NULL );
 
     void undo();
@@ -349,12 +348,8 @@ public:
 private:
     const float m_gain;
     const int m_orderPos;
+    MainWindow* const m_mainWindow;
     WaveGraphicsScene* const m_graphicsScene;
-    const int m_sampleRate;
-    AudioFileHandler& m_fileHandler;
-    const QString m_tempDirPath;
-    const QString m_fileBaseName;
-    QString m_filePath;
 };
 
 
@@ -365,11 +360,8 @@ public:
     ApplyGainRampCommand( float startGain,
                           float endGain,
                           int waveformItemOrderPos,
+                          MainWindow* mainWindow,
                           WaveGraphicsScene* graphicsScene,
-                          int sampleRate,
-                          AudioFileHandler& fileHandler,
-                          QString tempDirPath,
-                          QString fileBaseName,
                           QUndoCommand* parent = NULL );
 
     void undo();
@@ -379,12 +371,8 @@ private:
     const float m_startGain;
     const float m_endGain;
     const int m_orderPos;
+    MainWindow* const m_mainWindow;
     WaveGraphicsScene* const m_graphicsScene;
-    const int m_sampleRate;
-    AudioFileHandler& m_fileHandler;
-    const QString m_tempDirPath;
-    const QString m_fileBaseName;
-    QString m_filePath;
 };
 
 
@@ -393,11 +381,8 @@ class NormaliseCommand : public QUndoCommand
 {
 public:
     NormaliseCommand( int waveformItemOrderPos,
+                      MainWindow* mainWindow,
                       WaveGraphicsScene* graphicsScene,
-                      int sampleRate,
-                      AudioFileHandler& fileHandler,
-                      QString tempDirPath,
-                      QString fileBaseName,
                       QUndoCommand* parent = NULL );
 
     void undo();
@@ -405,12 +390,9 @@ public:
 
 private:
     const int m_orderPos;
+    MainWindow* const m_mainWindow;
     WaveGraphicsScene* const m_graphicsScene;
-    const int m_sampleRate;
-    AudioFileHandler& m_fileHandler;
-    const QString m_tempDirPath;
-    const QString m_fileBaseName;
-    QString m_filePath;
+    bool m_isEditPushed;
 };
 
 
@@ -419,6 +401,7 @@ class ReverseCommand : public QUndoCommand
 {
 public:
     ReverseCommand( int waveformItemOrderPos,
+                    MainWindow* mainWindow,
                     WaveGraphicsScene* graphicsScene,
                     QUndoCommand* parent = NULL );
 
@@ -426,7 +409,8 @@ public:
     void redo();
 
 private:
-    const int mOrderPos;
+    const int m_orderPos;
+    MainWindow* const m_mainWindow;
     WaveGraphicsScene* const m_graphicsScene;
 };
 
@@ -207,6 +207,13 @@ bool ExportDialog::isOverwriteEnabled() const
 
 
 
+bool ExportDialog::isRenderEnabled() const
+{
+    return m_ui->checkBox_Render->isChecked();
+}
+
+
+
 int ExportDialog::getSndFileFormat() const
 {
     const int index = m_ui->comboBox_Encoding->currentIndex();
@@ -679,6 +686,7 @@ void ExportDialog::on_checkBox_ExportAudio_clicked( const bool isChecked )
     m_ui->comboBox_Format->setEnabled( isChecked );
     m_ui->comboBox_Model->setEnabled( isChecked );
     m_ui->comboBox_SampleRate->setEnabled( isChecked );
+    m_ui->checkBox_Render->setEnabled( isChecked );
 
     if ( !isChecked && m_ui->checkBox_ExportMidi->isChecked() )
     {
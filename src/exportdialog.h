@@ -65,6 +65,7 @@ public:
     QString getFileName() const;
     NumberingStyle getNumberingStyle() const;
     bool isOverwriteEnabled() const;
+    bool isRenderEnabled() const;
 
     int getSndFileFormat() const;
     int getSampleRate() const;
@@ -70,7 +70,6 @@ namespace ZValues
     const int SELECTED_WAVEFORM      = 1;
     const int SLICE_POINT            = 2;
     const int SELECTED_SLICE_POINT   = 3;
-    const int PLAYHEAD               = 4;
     const int BPM_RULER              = 5;
     const int BPM_RULER_TEXT         = 6;
 }
@@ -26,6 +26,7 @@
 #include <QFileDialog>
 #include <QDesktopWidget>
 #include <QScrollBar>
+#include <QDockWidget>
 #include "commands.h"
 #include "globals.h"
 #include "applygaindialog.h"
@@ -35,6 +36,7 @@
 #include "messageboxes.h"
 #include "sampleutils.h"
 #include "textfilehandler.h"
+#include "zerocrossingindex.h"
 #include <rubberband/RubberBandStretcher.h>
 #include <QtDebug>
 
@@ -346,7 +348,7 @@ void MainWindow::setUpSampler()
             const bool isJackSyncEnabled = m_optionsDialog->isJackSyncEnabled();
 
             m_rubberbandAudioSource = new RubberbandAudioSource( m_samplerAudioSource, numOutputChans, options, isJackSyncEnabled );
-            m_audioSourcePlayer.setSource( m_rubberbandAudioSource );
+            m_audioMeter = new AudioMeter( m_rubberbandAudioSource );
 
             connect( m_optionsDialog, SIGNAL( transientsOptionChanged(RubberBandStretcher::Options) ),
                      m_rubberbandAudioSource, SLOT( setTransientsOption(RubberBandStretcher::Options) ) );
@@ -367,9 +369,12 @@ void MainWindow::setUpSampler()
         }
         else // Offline time stretch mode
         {
-            m_audioSourcePlayer.setSource( m_samplerAudioSource );
+            m_audioMeter = new AudioMeter( m_samplerAudioSource );
         }
 
+        m_audioSourcePlayer.setSource( m_audioMeter );
+        m_audioMeterWidget->setAudioMeter( m_audioMeter );
+
         m_deviceManager.addAudioCallback( &m_audioSourcePlayer );
         m_deviceManager.addMidiInputCallback( String::empty, m_samplerAudioSource->getMidiMessageCollector() );
     }
@@ -385,6 +390,8 @@ void MainWindow::tearDownSampler()
     m_deviceManager.removeAudioCallback( &m_audioSourcePlayer );
     m_deviceManager.removeMidiInputCallback( String::empty, m_samplerAudioSource->getMidiMessageCollector() );
 
+    m_audioMeterWidget->setAudioMeter( NULL );
+    m_audioMeter = NULL;
     m_rubberbandAudioSource = NULL;
     m_samplerAudioSource = NULL;
 }
@@ -445,6 +452,18 @@ void MainWindow::setupUI()
     }
 
 
+    // Set up level and spectrum meters in a dock widget, which can be shown from the Options menu
+    m_audioMeterWidget = new AudioMeterWidget();
+
+    QDockWidget* const meterDockWidget = new QDockWidget( tr( "Meters" ), this );
+    meterDockWidget->setObjectName( "dockWidget_Meters" );
+    meterDockWidget->setWidget( m_audioMeterWidget );
+    addDockWidget( Qt::BottomDockWidgetArea, meterDockWidget );
+    meterDockWidget->hide();
+
+    m_ui->menuOptions->addAction( meterDockWidget->toggleViewAction() );
+
+
     // Set up interaction mode buttons to work like radio buttons
     m_interactionGroup = new QActionGroup( this );
     m_interactionGroup->addAction( m_ui->actionSelect_Move );
@@ -585,8 +604,15 @@ void MainWindow::setupUI()
     connect( m_ui->waveGraphicsView, SIGNAL( maxDetailLevelReached() ),
              this, SLOT( disableZoomIn() ) );
 
-    connect( m_graphicsScene, SIGNAL( playheadFinishedScrolling() ),
-             this, SLOT( resetPlayStopButtonIcon() ) );
+    m_playheadTimer.setInterval( PLAYHEAD_UPDATE_INTERVAL );
+
+    connect( &m_playheadTimer, SIGNAL( timeout() ),
+             this, SLOT( updatePlayhead() ) );
+
+    m_projectReaderTimer.setInterval( PROJECT_READER_POLL_INTERVAL );
+
+    connect( &m_projectReaderTimer, SIGNAL( timeout() ),
+             this, SLOT( checkProjectReader() ) );
 
     connect( m_graphicsScene, SIGNAL( selectionChanged() ),
              this, SLOT( enableEditActions() ) );
@@ -716,6 +742,7 @@ void MainWindow::enableUI()
         m_ui->actionClose_Project->setEnabled( true );
     }
     m_ui->actionExport_As->setEnabled( true );
+    m_ui->actionBounce->setEnabled( true );
     m_ui->actionSelect_All->setEnabled( true );
     m_ui->actionSelect_None->setEnabled( true );
     m_ui->actionAdd_Slice_Point->setEnabled( true );
@@ -776,6 +803,7 @@ void MainWindow::disableUI()
     m_ui->actionSave_As->setEnabled( false );
     m_ui->actionClose_Project->setEnabled( false );
     m_ui->actionExport_As->setEnabled( false );
+    m_ui->actionBounce->setEnabled( false );
     m_ui->actionSelect_All->setEnabled( false );
     m_ui->actionSelect_None->setEnabled( false );
     m_ui->actionAdd_Slice_Point->setEnabled( false );
@@ -850,6 +878,9 @@ void MainWindow::getDetectionSettings( AudioAnalyser::DetectionSettings& setting
 
 void MainWindow::closeProject()
 {
+    m_projectReaderTimer.stop();
+    m_projectReader = NULL;
+
     m_copiedSampleBuffers.clear();
     m_copiedEnvelopes.attackValues.clear();
     m_copiedEnvelopes.releaseValues.clear();
@@ -860,6 +891,9 @@ void MainWindow::closeProject()
     m_sampleBufferList.clear();
     tearDownSampler();
 
+    m_savedProjectFilePath.clear();
+    m_savedAudioFileNames.clear();
+
     disconnect( m_graphicsScene, SIGNAL( selectionChanged() ),
                 this, SLOT( enableEditActions() ) );
 
@@ -912,6 +946,8 @@ bool MainWindow::isSelectiveTimeStretchInUse() const
 
 QUndoCommand* MainWindow::createRenderCommand( QUndoCommand* parent )
 {
+    waitForSampleBuffers();
+
     const QString tempDirPath = m_optionsDialog->getTempDirPath();
 
     QUndoCommand* command = NULL;
@@ -961,26 +997,12 @@ void MainWindow::copySelectedSamplesToClipboard()
 {
     const QList<int> orderPositions = m_graphicsScene->getSelectedWaveformsOrderPositions();
 
-    // Copy sample buffers
+    // Copy sample buffers; the sample data is shared rather than copied
     m_copiedSampleBuffers.clear();
 
-    const int numChans = m_sampleHeader->numChans;
-    const int startFrame = 0;
-
     foreach ( int orderPos, orderPositions )
     {
-        SharedSampleBuffer origSampleBuffer = m_sampleBufferList.at( orderPos );
-
-        const int numFrames = origSampleBuffer->getNumFrames();
-
-        SharedSampleBuffer copiedSampleBuffer( new SampleBuffer( numChans, numFrames ) );
-
-        for ( int chanNum = 0; chanNum < numChans; chanNum++ )
-        {
-            copiedSampleBuffer->copyFrom( chanNum, startFrame, *origSampleBuffer.data(), chanNum, startFrame, numFrames );
-        }
-
-        m_copiedSampleBuffers << copiedSampleBuffer;
+        m_copiedSampleBuffers << SampleUtils::createSharedCopy( m_sampleBufferList.at( orderPos ) );
     }
 
     // Copy envelopes
@@ -1069,6 +1091,8 @@ QList<int> MainWindow::getSnapFrameNums() const
 
 void MainWindow::calculateBPM()
 {
+    waitForSampleBuffers();
+
     const int numerator = m_ui->comboBox_TimeSigNumerator->currentText().toInt();
 
     int numBeats = 0;
@@ -1096,7 +1120,7 @@ void MainWindow::calculateBPM()
         AudioAnalyser::DetectionSettings settings;
         getDetectionSettings( settings );
 
-        bpm = AudioAnalyser::calcBPM( m_sampleBufferList.first(), settings );
+        bpm = AudioAnalyser::calcBPM( SampleUtils::renderEdits( m_sampleBufferList.first() ), settings );
     }
 
     m_ui->doubleSpinBox_OriginalBPM->setValue( bpm );
@@ -1259,34 +1283,49 @@ void MainWindow::playSample( const WaveformItem* waveformItem, const QPointF mou
     m_samplerAudioSource->playSample( waveformItem->getOrderPos(), sampleRange );
     m_ui->pushButton_PlayStop->setIcon( QIcon( ":/resources/images/media-playback-stop.png" ) );
 
-    if ( m_rubberbandAudioSource != NULL && m_ui->checkBox_TimeStretch->isChecked() )
+    m_graphicsScene->startPlayhead( startPosX, endPosX, sampleRange->numFrames );
+    m_playheadTimer.start();
+}
+
+
+
+void MainWindow::stopPlayback()
+{
+    if ( m_samplerAudioSource != NULL )
     {
-        const qreal globalStretchRatio = m_ui->doubleSpinBox_OriginalBPM->value() / m_ui->doubleSpinBox_NewBPM->value();
+        m_samplerAudioSource->stop();
+    }
+    m_playheadTimer.stop();
+    m_graphicsScene->stopPlayhead();
+    m_ui->pushButton_PlayStop->setIcon( QIcon( ":/resources/images/media-playback-start.png" ) );
+}
 
-        const int startMidiNote = m_samplerAudioSource->getLowestAssignedMidiNote();
 
-        const qreal noteTimeRatio = m_rubberbandAudioSource->getNoteTimeRatio( startMidiNote + waveformItem->getOrderPos() );
 
-        const qreal stretchRatio = globalStretchRatio * noteTimeRatio;
+void MainWindow::updatePlayhead()
+{
+    const int frameNum = ( m_samplerAudioSource != NULL ) ? m_samplerAudioSource->getPlaybackFrameNum() : -1;
 
-        m_graphicsScene->startPlayhead( startPosX, endPosX, sampleRange->numFrames, m_ui->pushButton_Loop->isChecked(), stretchRatio );
+    if ( frameNum >= 0 )
+    {
+        m_graphicsScene->updatePlayhead( frameNum );
     }
-    else
+    else // Playback has finished
     {
-        m_graphicsScene->startPlayhead( startPosX, endPosX, sampleRange->numFrames, m_ui->pushButton_Loop->isChecked() );
+        m_playheadTimer.stop();
+        m_graphicsScene->stopPlayhead();
+        resetPlayStopButtonIcon();
     }
 }
 
 
 
-void MainWindow::stopPlayback()
+void MainWindow::checkProjectReader()
 {
-    if ( m_samplerAudioSource != NULL )
+    if ( m_projectReader == NULL || m_projectReader->isFinished() )
     {
-        m_samplerAudioSource->stop();
+        waitForSampleBuffers();
     }
-    m_graphicsScene->stopPlayhead();
-    m_ui->pushButton_PlayStop->setIcon( QIcon( ":/resources/images/media-playback-start.png" ) );
 }
 
 
@@ -1673,6 +1712,13 @@ void MainWindow::on_actionExport_As_triggered()
 
 
 
+void MainWindow::on_actionBounce_triggered()
+{
+    bounceDialog();
+}
+
+
+
 void MainWindow::on_actionQuit_triggered()
 {
     // Check for unsaved changes before quitting
@@ -1809,45 +1855,23 @@ void MainWindow::on_actionAdd_Slice_Point_triggered()
 
 void MainWindow::on_actionApply_Gain_triggered()
 {
-    const QString tempDirPath = m_optionsDialog->getTempDirPath();
+    ApplyGainDialog dialog;
 
-    if ( ! tempDirPath.isEmpty() )
+    const int result = dialog.exec();
+
+    if ( result == QDialog::Accepted )
     {
-        ApplyGainDialog dialog;
+        const QList<int> orderPositions = m_graphicsScene->getSelectedWaveformsOrderPositions();
 
-        const int result = dialog.exec();
+        QUndoCommand* parentCommand = new QUndoCommand();
+        parentCommand->setText( tr("Apply Gain") );
 
-        if ( result == QDialog::Accepted )
+        foreach ( int orderPos, orderPositions )
         {
-            const QList<int> orderPositions = m_graphicsScene->getSelectedWaveformsOrderPositions();
-
-            QUndoCommand* parentCommand = new QUndoCommand();
-            parentCommand->setText( tr("Apply Gain") );
-
-            const QString stackIndex = QString::number( m_undoStack.index() );
-            int i = 0;
-
-            foreach ( int orderPos, orderPositions )
-            {
-                QString fileBaseName = stackIndex + "_" + QString::number( i++ );
-
-                new ApplyGainCommand( dialog.getGainValue(),
-                                      orderPos,
-                                      m_graphicsScene,
-                                      m_sampleHeader->sampleRate,
-                                      m_fileHandler,
-                                      tempDirPath,
-                                      fileBaseName,
-                                      parentCommand );
-            }
-
-            m_undoStack.push( parentCommand );
+            new ApplyGainCommand( dialog.getGainValue(), orderPos, this, m_graphicsScene, parentCommand );
         }
-    }
-    else
-    {
-        MessageBoxes::showWarningDialog( tr( "Temp dir invalid!" ),
-                                         tr( "This operation needs to save temporary files, please change \"Temp Dir\" in options" ) );
+
+        m_undoStack.push( parentCommand );
     }
 }
 
@@ -1855,46 +1879,28 @@ void MainWindow::on_actionApply_Gain_triggered()
 
 void MainWindow::on_actionApply_Gain_Ramp_triggered()
 {
-    const QString tempDirPath = m_optionsDialog->getTempDirPath();
+    ApplyGainRampDialog dialog;
 
-    if ( ! tempDirPath.isEmpty() )
+    const int result = dialog.exec();
+
+    if ( result == QDialog::Accepted )
     {
-        ApplyGainRampDialog dialog;
+        const QList<int> orderPositions = m_graphicsScene->getSelectedWaveformsOrderPositions();
 
-        const int result = dialog.exec();
+        QUndoCommand* parentCommand = new QUndoCommand();
+        parentCommand->setText( tr("Apply Gain Ramp") );
 
-        if ( result == QDialog::Accepted )
+        foreach ( int orderPos, orderPositions )
         {
-            const QList<int> orderPositions = m_graphicsScene->getSelectedWaveformsOrderPositions();
-
-            QUndoCommand* parentCommand = new QUndoCommand();
-            parentCommand->setText( tr("Apply Gain Ramp") );
-
-            const QString stackIndex = QString::number( m_undoStack.index() );
-            int i = 0;
-
-            foreach ( int orderPos, orderPositions )
-            {
-                QString fileBaseName = stackIndex + "_" + QString::number( i++ );
-
-                new ApplyGainRampCommand( dialog.getStartGainValue(),
-                                          dialog.getEndGainValue(),
-                                          orderPos,
-                                          m_graphicsScene,
-                                          m_sampleHeader->sampleRate,
-                                          m_fileHandler,
-                                          tempDirPath,
-                                          fileBaseName,
-                                          parentCommand );
-            }
-
-            m_undoStack.push( parentCommand );
+            new ApplyGainRampCommand( dialog.getStartGainValue(),
+                                      dialog.getEndGainValue(),
+                                      orderPos,
+                                      this,
+                                      m_graphicsScene,
+                                      parentCommand );
         }
-    }
-    else
-    {
-        MessageBoxes::showWarningDialog( tr( "Temp dir invalid!" ),
-                                         tr( "This operation needs to save temporary files, please change \"Temp Dir\" in options" ) );
+
+        m_undoStack.push( parentCommand );
     }
 }
 
@@ -1902,38 +1908,19 @@ void MainWindow::on_actionApply_Gain_Ramp_triggered()
 
 void MainWindow::on_actionNormalise_triggered()
 {
-    const QString tempDirPath = m_optionsDialog->getTempDirPath();
+    waitForSampleBuffers();
 
-    if ( ! tempDirPath.isEmpty() )
-    {
-        const QList<int> orderPositions = m_graphicsScene->getSelectedWaveformsOrderPositions();
-
-        QUndoCommand* parentCommand = new QUndoCommand();
-        parentCommand->setText( tr("Normalise") );
-
-        const QString stackIndex = QString::number( m_undoStack.index() );
-        int i = 0;
-
-        foreach ( int orderPos, orderPositions )
-        {
-            QString fileBaseName = stackIndex + "_" + QString::number( i++ );
+    const QList<int> orderPositions = m_graphicsScene->getSelectedWaveformsOrderPositions();
 
-            new NormaliseCommand( orderPos,
-                                  m_graphicsScene,
-                                  m_sampleHeader->sampleRate,
-                                  m_fileHandler,
-                                  tempDirPath,
-                                  fileBaseName,
-                                  parentCommand );
-        }
+    QUndoCommand* parentCommand = new QUndoCommand();
+    parentCommand->setText( tr("Normalise") );
 
-        m_undoStack.push( parentCommand );
-    }
-    else
+    foreach ( int orderPos, orderPositions )
     {
-        MessageBoxes::showWarningDialog( tr( "Temp dir invalid!" ),
-                                         tr( "This operation needs to save temporary files, please change \"Temp Dir\" in options" ) );
+        new NormaliseCommand( orderPos, this, m_graphicsScene, parentCommand );
     }
+
+    m_undoStack.push( parentCommand );
 }
 
 
@@ -1947,7 +1934,7 @@ void MainWindow::on_actionReverse_triggered()
 
     foreach ( int orderPos, orderPositions )
     {
-        new ReverseCommand( orderPos, m_graphicsScene, parentCommand );
+        new ReverseCommand( orderPos, this, m_graphicsScene, parentCommand );
     }
 
     m_undoStack.push( parentCommand );
@@ -2024,6 +2011,8 @@ void MainWindow::on_pushButton_CalcBPM_clicked()
 
 void MainWindow::on_pushButton_Slice_clicked( const bool isChecked )
 {
+    waitForSampleBuffers();
+
     if ( isChecked ) // Slice
     {
         if ( m_graphicsScene->getSlicePointFrameNums().isEmpty() )
@@ -2116,18 +2105,23 @@ void MainWindow::on_horizontalSlider_Threshold_valueChanged( const int value )
 
 void MainWindow::on_pushButton_Find_clicked()
 {
+    waitForSampleBuffers();
+
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
 
     // Get detection settings
     AudioAnalyser::DetectionSettings settings;
     getDetectionSettings( settings );
 
+    // Analyse the sample data as it will actually be heard, with any non-destructive edits applied
+    const SharedSampleBuffer sampleBuffer = SampleUtils::renderEdits( m_sampleBufferList.first() );
+
     // Find slice points
     QList<int> slicePointFrameNumList;
 
     if ( m_ui->comboBox_Find->currentText() == tr( "Onsets" ) )
     {
-        slicePointFrameNumList = AudioAnalyser::findOnsetFrameNums( m_sampleBufferList.first(), settings );
+        slicePointFrameNumList = AudioAnalyser::findOnsetFrameNums( sampleBuffer, settings );
     }
     else // Find Beats
     {
@@ -2137,18 +2131,27 @@ void MainWindow::on_pushButton_Find_clicked()
         }
         else
         {
-            slicePointFrameNumList = AudioAnalyser::findBeatFrameNums( m_sampleBufferList.first(), settings );
+            slicePointFrameNumList = AudioAnalyser::findBeatFrameNums( sampleBuffer, settings );
         }
     }
 
-    // Adjust slice points according to zero-crossing settings
+    // Adjust slice points according to zero-crossing settings - when there are enough slice points to adjust,
+    // index the sign changes in the sample data once so that each slice point doesn't need a scan of its own
+    ScopedPointer<ZeroCrossingIndex> zeroCrossingIndex;
+
+    if ( m_ui->comboBox_ZeroCrossings->currentText() != tr( "Ignore" ) &&
+         ZeroCrossingIndex::isWorthBuilding( sampleBuffer->getNumFrames(), slicePointFrameNumList.size() ) )
+    {
+        zeroCrossingIndex = new ZeroCrossingIndex( sampleBuffer );
+    }
+
     if ( m_ui->comboBox_ZeroCrossings->currentText() == tr( "Closest" ) )
     {
         for ( int i = 0; i < slicePointFrameNumList.size(); i++ )
         {
             int frameNum = slicePointFrameNumList.at( i );
 
-            frameNum = SampleUtils::getClosestZeroCrossing( m_sampleBufferList.first(), frameNum );
+            frameNum = SampleUtils::getClosestZeroCrossing( sampleBuffer, frameNum, zeroCrossingIndex );
 
             slicePointFrameNumList.replace( i, frameNum );
         }
@@ -2159,7 +2162,7 @@ void MainWindow::on_pushButton_Find_clicked()
         {
             int frameNum = slicePointFrameNumList.at( i );
 
-            frameNum = SampleUtils::getNextZeroCrossing( m_sampleBufferList.first(), frameNum );
+            frameNum = SampleUtils::getNextZeroCrossing( sampleBuffer, frameNum, zeroCrossingIndex );
 
             slicePointFrameNumList.replace( i, frameNum );
         }
@@ -2170,7 +2173,7 @@ void MainWindow::on_pushButton_Find_clicked()
         {
             int frameNum = slicePointFrameNumList.at( i );
 
-            frameNum = SampleUtils::getPrevZeroCrossing( m_sampleBufferList.first(), frameNum );
+            frameNum = SampleUtils::getPrevZeroCrossing( sampleBuffer, frameNum, zeroCrossingIndex );
 
             slicePointFrameNumList.replace( i, frameNum );
         }
@@ -2258,8 +2261,6 @@ void MainWindow::on_doubleSpinBox_OriginalBPM_valueChanged( const double origina
             const qreal timeRatio = originalBPM / newBPM;
 
             m_rubberbandAudioSource->setGlobalTimeRatio( timeRatio );
-
-            m_graphicsScene->updatePlayheadSpeed( timeRatio );
         }
     }
 
@@ -2283,8 +2284,6 @@ void MainWindow::on_doubleSpinBox_NewBPM_valueChanged( const double newBPM )
         const qreal timeRatio = originalBPM / newBPM;
 
         m_rubberbandAudioSource->setGlobalTimeRatio( timeRatio );
-
-        m_graphicsScene->updatePlayheadSpeed( timeRatio );
     }
 }
 
@@ -2331,6 +2330,7 @@ void MainWindow::on_pushButton_PlayStop_clicked()
     if ( m_graphicsScene->isPlayheadScrolling() )
     {
         m_samplerAudioSource->stop();
+        m_playheadTimer.stop();
         m_graphicsScene->stopPlayhead();
         m_ui->pushButton_PlayStop->setIcon( QIcon( ":/resources/images/media-playback-start.png" ) );
     }
@@ -2340,15 +2340,8 @@ void MainWindow::on_pushButton_PlayStop_clicked()
         
         m_ui->pushButton_PlayStop->setIcon( QIcon( ":/resources/images/media-playback-stop.png" ) );
 
-        if ( m_rubberbandAudioSource != NULL && m_ui->checkBox_TimeStretch->isChecked() )
-        {
-            qreal stretchRatio = m_ui->doubleSpinBox_OriginalBPM->value() / m_ui->doubleSpinBox_NewBPM->value();
-            m_graphicsScene->startPlayhead( m_ui->pushButton_Loop->isChecked(), stretchRatio );
-        }
-        else
-        {
-            m_graphicsScene->startPlayhead( m_ui->pushButton_Loop->isChecked() );
-        }
+        m_graphicsScene->startPlayhead();
+        m_playheadTimer.start();
     }
 }
 
@@ -2360,7 +2353,6 @@ void MainWindow::on_pushButton_Loop_clicked( const bool isChecked )
     {
         m_samplerAudioSource->setLooping( isChecked );
     }
-    m_graphicsScene->setPlayheadLooping( isChecked );
 }
 
 
@@ -2392,6 +2384,8 @@ void MainWindow::on_actionZoom_Original_triggered()
 
 void MainWindow::on_pushButton_Apply_clicked()
 {
+    waitForSampleBuffers();
+
     const QString tempDirPath = m_optionsDialog->getTempDirPath();
 
     if ( ! tempDirPath.isEmpty() )
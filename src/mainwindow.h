@@ -27,12 +27,17 @@
 #include <QList>
 #include <QUndoStack>
 #include <QActionGroup>
+#include <QTimer>
+#include <QHash>
+#include <QDateTime>
 #include "JuceHeader.h"
 #include "samplebuffer.h"
 #include "optionsdialog.h"
 #include "audiofilehandler.h"
 #include "sampleraudiosource.h"
 #include "rubberbandaudiosource.h"
+#include "audiometer.h"
+#include "audiometerwidget.h"
 #include "wavegraphicsscene.h"
 #include "slicepointitem.h"
 #include "audioanalyser.h"
@@ -41,6 +46,7 @@
 #include "exportdialog.h"
 #include "nsmlistenerthread.h"
 #include "jackoutputsdialog.h"
+#include "projectreader.h"
 
 
 namespace Ui
@@ -90,6 +96,13 @@ private:
 
     void saveProject( QString filePath, bool isNsmSessionExport = false );
     void openProject( QString filePath );
+
+    // Block until the audio of the last opened project has all been decoded in the background.
+    // This must be done before anything that reads the sample data
+    void waitForSampleBuffers();
+
+    // Mark the sample buffers clean, recording that they are stored in "filePath" under "audioFileNames"
+    void setSavedProject( QString filePath, QStringList audioFileNames );
     void importAudioFile( QString filePath );
     void exportAs( QString tempDirPath,
                    QString outputDirPath,
@@ -99,11 +112,13 @@ private:
                    int sndFileFormat,
                    int outputSampleRate,
                    int numSamplesToExport );
+    void bounce( QString filePath );
 
     void saveProjectDialog();
     void openProjectDialog();
     void importAudioFileDialog();
     void exportAsDialog();
+    void bounceDialog();
 
     void addPathToRecentProjects( QString filePath );
 
@@ -137,14 +152,34 @@ private:
     SharedSampleHeader m_sampleHeader;
     QList<SharedSampleBuffer> m_sampleBufferList;
 
+    // Decodes the audio of the last opened project into its sample buffers until it has all been decoded
+    ScopedPointer<ProjectReader> m_projectReader;
+
+    // Polls the project reader so that it can be released, and any audio that couldn't be decoded reported
+    QTimer m_projectReaderTimer;
+    static const int PROJECT_READER_POLL_INTERVAL = 250; // Milliseconds
+
     ScopedPointer<SamplerAudioSource> m_samplerAudioSource;
     ScopedPointer<RubberbandAudioSource> m_rubberbandAudioSource;
+    ScopedPointer<AudioMeter> m_audioMeter;
     AudioSourcePlayer m_audioSourcePlayer;
 
+    AudioMeterWidget* m_audioMeterWidget;
+
+    // Polls the sampler's playback position to move the playhead
+    QTimer m_playheadTimer;
+    static const int PLAYHEAD_UPDATE_INTERVAL = 17; // Milliseconds - roughly 60 fps
+
     QString m_lastOpenedImportDir;
     QString m_lastOpenedProjDir;
     QString m_currentProjectFilePath;
 
+    // The project file last saved or opened, and the name of the audio file each clean sample buffer was
+    // stored under in it, so that saving again to the same file only has to write the dirty sample buffers
+    QString m_savedProjectFilePath;
+    QDateTime m_savedProjectModTime;
+    QHash<const SampleBuffer*, QString> m_savedAudioFileNames;
+
     QUndoStack m_undoStack;
 
     qreal m_appliedBPM;
@@ -212,6 +247,7 @@ private slots:
     void on_actionAdd_Slice_Point_triggered();
     void on_actionQuit_triggered();
     void on_actionExport_As_triggered();
+    void on_actionBounce_triggered();
     void on_actionImport_Audio_File_triggered();
     void on_actionClose_Project_triggered();
     void on_actionSave_As_triggered();
@@ -231,6 +267,10 @@ private slots:
 
     void stopPlayback();
 
+    void updatePlayhead();
+
+    void checkProjectReader();
+
     void resetPlayStopButtonIcon();
 
     void disableZoomIn();
@@ -25,13 +25,20 @@
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QDesktopWidget>
+#include <QProgressDialog>
 #include "commands.h"
 #include "globals.h"
 #include "zipper.h"
+#include "zipwriter.h"
+#include "sliceexporter.h"
+#include "slicerenderer.h"
+#include "targzwriter.h"
+#include "offlinebouncer.h"
 #include "messageboxes.h"
 #include "textfilehandler.h"
 #include "akaifilehandler.h"
 #include "midifilehandler.h"
+#include "sampleutils.h"
 #include "confirmbpmdialog.h"
 //#include <QtDebug>
 
@@ -46,56 +53,127 @@ void MainWindow::saveProject( const QString filePath, const bool isNsmSessionExp
         return;
     }
 
-    const QString tempDirPath = m_optionsDialog->getTempDirPath();
+    waitForSampleBuffers();
+
+    QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
+
+    const QString projectName = QFileInfo( filePath ).baseName();
+    const String entryDirName = String::fromUTF8( projectName.toUtf8().constData() ) + "/";
+
+    // Each sample buffer is encoded straight into the archive, which is written to a temp file beside the project
+    // file and only replaces it once the whole archive has been written successfully
+    ZipWriter zipWriter( File( filePath.toLocal8Bit().data() ) );
 
-    if ( tempDirPath.isEmpty() )
+    if ( zipWriter.failedToOpen() )
     {
-        MessageBoxes::showWarningDialog( tr("Temp directory is invalid!"),
-                                         tr("This operation needs to save temporary files, please change \"Temp Dir\" in options") );
+        QApplication::restoreOverrideCursor();
+        MessageBoxes::showWarningDialog( tr("Couldn't save project!"),
+                                         tr("The project file could not be opened for writing") );
         return;
     }
 
-    QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
+    const AudioFileHandler::ProjectStorage storage = m_optionsDialog->getProjectStorage();
+    const bool isFlacStorage = storage == AudioFileHandler::STORE_FLAC;
+    const int compressionLevel = AudioFileHandler::getCompressionLevel( storage );
 
-    const QString zipFileName = QFileInfo( filePath ).fileName();
-    const QString projectName = QFileInfo( filePath ).baseName();
+    // If the project was last saved to or opened from this file, and the file hasn't been changed since,
+    // the audio of clean sample buffers can be copied from the existing file rather than written again
+    const bool isIncrementalSave = ! isNsmSessionExport &&
+                                   filePath == m_savedProjectFilePath &&
+                                   QFileInfo( filePath ).lastModified() == m_savedProjectModTime;
+
+    const QStringList existingEntryNames = isIncrementalSave ? Zipper::getEntryNames( filePath ) : QStringList();
 
-    QDir tempDir( tempDirPath );
+    QStringList keptAudioFileNames;
+    StringArray entryNamesToKeep;
 
-    // Should not happen, but just as a precaution...
-    if ( tempDir.exists( projectName ) )
+    foreach ( SharedSampleBuffer sampleBuffer, m_sampleBufferList )
     {
-        tempDir.rename( projectName, projectName + ".bak" );
-    }
+        QString fileName;
 
-    tempDir.mkdir( projectName );
+        if ( isIncrementalSave && ! sampleBuffer->isDirty() && m_savedAudioFileNames.contains( sampleBuffer.data() ) )
+        {
+            const QString savedFileName = m_savedAudioFileNames.value( sampleBuffer.data() );
+            const QString audioEntryName = projectName + "/" + savedFileName;
+            const QString peakEntryName = projectName + "/" + QFileInfo( savedFileName ).completeBaseName() + ".peaks";
 
-    QDir projTempDir( tempDir.absoluteFilePath( projectName ) );
+            if ( existingEntryNames.contains( audioEntryName ) )
+            {
+                fileName = savedFileName;
 
-    const QString zipFilePath = tempDir.absoluteFilePath( zipFileName );
+                entryNamesToKeep.addIfNotAlreadyThere( String::fromUTF8( audioEntryName.toUtf8().constData() ) );
 
-    const QString xmlFilePath = projTempDir.absoluteFilePath( "shuriken.xml" );
+                if ( existingEntryNames.contains( peakEntryName ) )
+                {
+                    entryNamesToKeep.addIfNotAlreadyThere( String::fromUTF8( peakEntryName.toUtf8().constData() ) );
+                }
+            }
+        }
+
+        keptAudioFileNames << fileName;
+    }
+
+    // If the existing entries can't be copied after all, write every sample buffer instead
+    if ( ! entryNamesToKeep.isEmpty() && ! zipWriter.copyEntries( File( filePath.toLocal8Bit().data() ), entryNamesToKeep ) )
+    {
+        for ( int i = 0; i < keptAudioFileNames.size(); i++ )
+        {
+            keptAudioFileNames[ i ].clear();
+        }
+    }
+
+    QStringList keptBaseNames;
+
+    foreach ( QString fileName, keptAudioFileNames )
+    {
+        keptBaseNames << QFileInfo( fileName ).completeBaseName();
+    }
 
     bool isOkToContinue = true;
     QStringList audioFileNames;
+    int fileNum = 0;
 
-    for ( int i = 0; i < m_sampleBufferList.size(); i++ )
+    for ( int i = 0; i < m_sampleBufferList.size() && isOkToContinue; i++ )
     {
-        const QString audioFilePath = m_fileHandler.saveAudioFile( projTempDir.absolutePath(),
-                                                                   "audio" + QString::number( i ),
-                                                                   m_sampleBufferList.at( i ),
-                                                                   m_sampleHeader->sampleRate,
-                                                                   m_sampleHeader->sampleRate,
-                                                                   AudioFileHandler::SAVE_FORMAT );
+        if ( ! keptAudioFileNames.at( i ).isEmpty() )
+        {
+            audioFileNames << keptAudioFileNames.at( i );
+            continue;
+        }
 
-        if ( ! audioFilePath.isEmpty() )
+        // Don't reuse the name of an audio file that is being kept
+        while ( keptBaseNames.contains( "audio" + QString::number( fileNum ) ) )
         {
-            audioFileNames << QFileInfo( audioFilePath ).fileName();
+            fileNum++;
+        }
+
+        const SharedSampleBuffer sampleBuffer = SampleUtils::renderEdits( m_sampleBufferList.at( i ) );
+
+        const QString baseName = "audio" + QString::number( fileNum );
+        const QString fileName = baseName + ( isFlacStorage ? ".flac" : ".wav" );
+        const String entryName = entryDirName + String::fromUTF8( fileName.toUtf8().constData() );
+        QByteArray audioFileHash;
+
+        OutputStream& audioStream = *zipWriter.beginEntry( entryName, compressionLevel );
+
+        const bool isSaved = isFlacStorage ?
+                             m_fileHandler.saveFlacStream( audioStream, sampleBuffer, m_sampleHeader->sampleRate, audioFileHash ) :
+                             m_fileHandler.saveAudioStream( audioStream, sampleBuffer, m_sampleHeader->sampleRate, audioFileHash );
+
+        if ( isSaved )
+        {
+            audioFileNames << fileName;
+            fileNum++;
+
+            // Store the waveform's peaks so they don't have to be recalculated when the project is opened
+            OutputStream& peakStream = *zipWriter.beginEntry( entryDirName + String::fromUTF8( baseName.toUtf8().constData() ) + ".peaks",
+                                                              jmax( compressionLevel, 1 ) );
+
+            m_fileHandler.savePeakStream( peakStream, audioFileHash, sampleBuffer );
         }
         else
         {
             isOkToContinue = false;
-            break;
         }
     }
 
@@ -150,14 +228,20 @@ void MainWindow::saveProject( const QString filePath, const bool isNsmSessionExp
 
         settings.isMonophonyEnabled = m_ui->actionMonophonic->isChecked();
 
-        TextFileHandler::createProjectXmlFile( xmlFilePath, settings );
+        TextFileHandler::writeProjectXml( *zipWriter.beginEntry( entryDirName + "shuriken.xml", 9 ), settings );
 
-        Zipper::compress( projTempDir.absolutePath(), zipFilePath );
+        if ( ! zipWriter.finish() )
+        {
+            QApplication::restoreOverrideCursor();
+            MessageBoxes::showWarningDialog( tr("Couldn't save project!"),
+                                             tr("An error occurred while writing the project file") );
+            return;
+        }
 
-        QFile::remove( filePath );
-        QFile::copy( zipFilePath, filePath );
-        QFile::remove( zipFilePath );
-        File( projTempDir.absolutePath().toLocal8Bit().data() ).deleteRecursively();
+        if ( ! isNsmSessionExport )
+        {
+            setSavedProject( filePath, audioFileNames );
+        }
 
         if ( m_nsmThread != NULL )
         {
@@ -197,58 +281,23 @@ void MainWindow::openProject( const QString filePath )
         return;
     }
 
-    const QString tempDirPath = m_optionsDialog->getTempDirPath();
-
-    if ( tempDirPath.isEmpty() )
-    {
-        MessageBoxes::showWarningDialog( tr("Temp directory is invalid!"),
-                                         tr("This operation needs to save temporary files, please change \"Temp Dir\" in options") );
-        return;
-    }
-
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
 
-    Zipper::decompress( filePath, tempDirPath );
-
     const QFileInfo zipFileInfo( filePath );
     const QString projectName = zipFileInfo.baseName();
 
-    const QDir tempDir( tempDirPath );
-    QDir projTempDir = tempDir.absoluteFilePath( projectName );
-
-    const QString xmlFilePath = projTempDir.absoluteFilePath( "shuriken.xml" );
+    // Read the project straight from the archive rather than extracting it first
+    ScopedPointer<ProjectReader> projectReader( new ProjectReader( filePath, projectName ) );
     TextFileHandler::ProjectSettings settings;
 
-    const bool isSuccessful = TextFileHandler::readProjectXmlFile( xmlFilePath, settings );
+    const bool isSuccessful = projectReader->readProjectSettings( settings );
 
     if ( isSuccessful )
     {
         closeProject();
 
-        bool isOkToContinue = true;
-
-        // Try to load the audio files
-        foreach ( QString fileName, settings.audioFileNames )
-        {
-            const QString audioFilePath = projTempDir.absoluteFilePath( fileName );
-            SharedSampleBuffer sampleBuffer = m_fileHandler.getSampleData( audioFilePath );
-
-            if ( ! sampleBuffer.isNull() )
-            {
-                m_sampleBufferList << sampleBuffer;
-            }
-            else
-            {
-                isOkToContinue = false;
-                break;
-            }
-        }
-
-        // Try to read the audio file header info
-        {
-            const QString audioFilePath = projTempDir.absoluteFilePath( settings.audioFileNames.first() );
-            m_sampleHeader = m_fileHandler.getSampleHeader( audioFilePath );
-        }
+        // Try to load the audio files; only their headers are read before the project is shown
+        bool isOkToContinue = projectReader->readSampleBuffers( settings.audioFileNames, m_sampleBufferList, m_sampleHeader );
 
         if ( m_sampleHeader.isNull() )
         {
@@ -261,20 +310,13 @@ void MainWindow::openProject( const QString filePath )
             // Deal with sample ranges - provides backward compatibility with older save file format
             if ( ! settings.sampleRangeList.isEmpty() )
             {
-                const int numChans = m_sampleHeader->numChans;
-
                 QList<SharedSampleBuffer> tempSampleBuffers;
 
                 foreach ( SharedSampleRange range, settings.sampleRangeList )
                 {
-                    SharedSampleBuffer sampleBuffer( new SampleBuffer( numChans, range->numFrames ) );
-
-                    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
-                    {
-                        sampleBuffer->copyFrom( chanNum, 0, *m_sampleBufferList.first().data(), chanNum, range->startFrame, range->numFrames );
-                    }
-
-                    tempSampleBuffers << sampleBuffer;
+                    tempSampleBuffers << SharedSampleBuffer( new SampleBuffer( *m_sampleBufferList.first().data(),
+                                                                               range->startFrame,
+                                                                               range->numFrames ) );
                 }
 
                 m_sampleBufferList = tempSampleBuffers;
@@ -377,8 +419,8 @@ void MainWindow::openProject( const QString filePath )
 
             m_samplerAudioSource->setEnvelopeSettings( envelopes );
 
-            // Clean up temp dir
-            File( projTempDir.absolutePath().toLocal8Bit().data() ).deleteRecursively();
+            // Sample buffers made from sample ranges aren't stored in the file as they are
+            setSavedProject( filePath, settings.sampleRangeList.isEmpty() ? settings.audioFileNames : QStringList() );
 
             // Store file path for later use unless under NSM management
             if ( m_nsmThread == NULL )
@@ -391,6 +433,10 @@ void MainWindow::openProject( const QString filePath )
 
             m_isProjectOpen = true;
 
+            // Keep decoding the audio in the background, starting with the slices that are being shown
+            m_projectReader = projectReader.release();
+            m_projectReaderTimer.start();
+
             QApplication::restoreOverrideCursor();
         }
         else // Error loading audio files
@@ -400,13 +446,62 @@ void MainWindow::openProject( const QString filePath )
 
             QApplication::restoreOverrideCursor();
 
-            MessageBoxes::showWarningDialog( m_fileHandler.getLastErrorTitle(), m_fileHandler.getLastErrorInfo() );
+            MessageBoxes::showWarningDialog( tr("Couldn't open project!"),
+                                             tr("The audio in the project file is missing or can't be decoded") );
         }
     }
+    else // Error reading project settings
+    {
+        QApplication::restoreOverrideCursor();
+
+        MessageBoxes::showWarningDialog( tr("Couldn't open project!"),
+                                         tr("The project file is damaged or isn't a Shuriken project") );
+    }
+}
+
+
+
+void MainWindow::waitForSampleBuffers()
+{
+    m_projectReaderTimer.stop();
+
+    if ( m_projectReader == NULL )
+    {
+        return;
+    }
+
+    QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
+
+    const bool isSuccessful = m_projectReader->waitForSampleBuffers();
+    m_projectReader = NULL;
+
+    QApplication::restoreOverrideCursor();
+
+    if ( ! isSuccessful )
+    {
+        MessageBoxes::showWarningDialog( tr("Couldn't decode audio!"),
+                                         tr("Some of the audio in the project file can't be decoded, so those slices have been left silent") );
+    }
 }
 
 
 
+void MainWindow::setSavedProject( const QString filePath, const QStringList audioFileNames )
+{
+    m_savedProjectFilePath = filePath;
+    m_savedProjectModTime = QFileInfo( filePath ).lastModified();
+    m_savedAudioFileNames.clear();
+
+    for ( int i = 0; i < m_sampleBufferList.size() && i < audioFileNames.size(); i++ )
+    {
+        const SharedSampleBuffer sampleBuffer = m_sampleBufferList.at( i );
+
+        sampleBuffer->setClean();
+        m_savedAudioFileNames.insert( sampleBuffer.data(), audioFileNames.at( i ) );
+    }
+}
+
+
 void MainWindow::importAudioFile( const QString filePath )
 {
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
@@ -474,6 +569,8 @@ void MainWindow::exportAs( const QString tempDirPath,
                            const int outputSampleRate,
                            const int numSamplesToExport )
 {
+    waitForSampleBuffers();
+
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
 
     const QDir outputDir( outputDirPath );
@@ -484,19 +581,61 @@ void MainWindow::exportAs( const QString tempDirPath,
     const bool isExportTypeAkaiPgm    = exportType & ExportDialog::EXPORT_AKAI_PGM;
     const bool isExportTypeMidiFile   = exportType & ExportDialog::EXPORT_MIDI_FILE;
 
-    if ( isExportTypeAudioFiles )
+    // The slices of a Hydrogen drumkit are written straight into its archive
+    if ( isExportTypeAudioFiles && ! isExportTypeH2Drumkit )
     {
         outputDir.mkdir( fileName );
     }
 
     QStringList audioFileNames;
     bool isSuccessful = true;
+    bool isCancelled = false;
+    QString errorTitle;
+    QString errorInfo;
+
+    SamplerAudioSource::EnvelopeSettings envelopes;
+    m_samplerAudioSource->getEnvelopeSettings( envelopes );
+
+    const bool isRenderEnabled = isExportTypeAudioFiles && m_exportDialog->isRenderEnabled();
+
+    // Rendering bakes in what's heard on playback: each slice's attack envelope and, in real-time mode,
+    // its time stretch. The release depends on when the note is let go, so that's left to the sampler
+    const bool isTimeStretchRendered = isRenderEnabled && m_rubberbandAudioSource != NULL && m_ui->checkBox_TimeStretch->isChecked();
 
-    // Export audio files
+    qreal globalTimeRatio = 1.0;
+    bool isPitchCorrectionEnabled = true;
+
+    if ( isTimeStretchRendered )
+    {
+        globalTimeRatio = m_ui->doubleSpinBox_OriginalBPM->value() / m_ui->doubleSpinBox_NewBPM->value();
+        isPitchCorrectionEnabled = m_ui->checkBox_PitchCorrection->isChecked();
+    }
+
+    SliceExporter sliceExporter( m_fileHandler );
+
+    // Export audio files - slices are rendered, resampled and encoded on several threads at once
     if ( isExportTypeAudioFiles )
     {
+        QStringList audioFileBaseNames;
+
         for ( int i = 0; i < numSamplesToExport; i++ )
         {
+            SliceRenderer::Settings renderSettings;
+
+            if ( isRenderEnabled )
+            {
+                renderSettings.attackValue = envelopes.attackValues.at( i );
+
+                if ( m_rubberbandAudioSource != NULL )
+                {
+                    const int midiNote = m_samplerAudioSource->getLowestAssignedMidiNote() + i;
+
+                    renderSettings.timeRatio = globalTimeRatio * m_rubberbandAudioSource->getNoteTimeRatio( midiNote );
+                    renderSettings.pitchScale = isPitchCorrectionEnabled ? 1.0 : 1.0 / globalTimeRatio;
+                    renderSettings.stretcherOptions = m_optionsDialog->getStretcherOptions();
+                }
+            }
+
             QString audioFileName = fileName;
 
             if ( isExportTypeAkaiPgm && audioFileName.size() > 14 )
@@ -513,69 +652,154 @@ void MainWindow::exportAs( const QString tempDirPath,
                 audioFileName.append( QString::number( i + 1 ).rightJustified( 2, '0' ) );
             }
 
-            const QString path = m_fileHandler.saveAudioFile( samplesDirPath,
-                                                              audioFileName,
-                                                              m_sampleBufferList.at( i ),
-                                                              m_sampleHeader->sampleRate,
-                                                              outputSampleRate,
-                                                              sndFileFormat );
+            audioFileBaseNames << audioFileName;
+
+            if ( isExportTypeH2Drumkit )
+            {
+                sliceExporter.addSlice( m_sampleBufferList.at( i ),
+                                        audioFileName,
+                                        m_sampleHeader->sampleRate,
+                                        outputSampleRate,
+                                        sndFileFormat,
+                                        renderSettings );
+            }
+            else
+            {
+                sliceExporter.addSlice( m_sampleBufferList.at( i ),
+                                        samplesDirPath,
+                                        audioFileName,
+                                        m_sampleHeader->sampleRate,
+                                        outputSampleRate,
+                                        sndFileFormat,
+                                        renderSettings );
+            }
+        }
+
+        QProgressDialog progressDialog( tr("Exporting audio files..."), tr("Cancel"), 0, numSamplesToExport, this );
+        progressDialog.setWindowModality( Qt::WindowModal );
+        progressDialog.setMinimumDuration( 500 );
+
+        while ( ! sliceExporter.waitForDone( 50 ) )
+        {
+            // Being window modal, the dialog processes events whenever its value is set
+            progressDialog.setValue( sliceExporter.getNumSlicesDone() );
+
+            if ( progressDialog.wasCanceled() )
+            {
+                sliceExporter.cancel();
+            }
+        }
+
+        progressDialog.setValue( numSamplesToExport );
+
+        const QStringList filePaths = sliceExporter.getFilePaths();
+
+        if ( sliceExporter.isCancelled() )
+        {
+            // Don't leave a partial export behind
+            if ( ! isExportTypeH2Drumkit )
+            {
+                foreach ( QString path, filePaths )
+                {
+                    if ( ! path.isEmpty() )
+                    {
+                        QFile::remove( path );
+                    }
+                }
+            }
 
-            if ( ! path.isEmpty() )
+            isSuccessful = false;
+            isCancelled = true;
+        }
+        else if ( ! sliceExporter.wasSuccessful() )
+        {
+            isSuccessful = false;
+            errorTitle = sliceExporter.getErrorTitle();
+            errorInfo = sliceExporter.getErrorInfo();
+        }
+        else
+        {
+            for ( int i = 0; i < filePaths.size(); i++ )
             {
                 if ( isExportTypeAkaiPgm )
                 {
-                    audioFileNames << audioFileName;    // File base name, no extension
+                    audioFileNames << audioFileBaseNames.at( i );       // File base name, no extension
                 }
                 else
                 {
-                    audioFileNames << QFileInfo( path ).fileName(); // File name including extension
+                    audioFileNames << QFileInfo( filePaths.at( i ) ).fileName(); // File name including extension
                 }
             }
-            else
-            {
-                isSuccessful = false;
-                break;
-            }
+        }
+    }
+
+    // The sample data as it was exported. SFZ release times and MIDI note lengths have to follow any rendered stretch
+    QList<SharedSampleBuffer> exportedSampleBuffers = m_sampleBufferList;
+
+    if ( isSuccessful && isExportTypeAudioFiles )
+    {
+        exportedSampleBuffers.clear();
+
+        for ( int i = 0; i < numSamplesToExport; i++ )
+        {
+            exportedSampleBuffers << sliceExporter.getSampleBuffer( i );
+        }
+    }
+
+    // Once rendered, the attack is part of the audio and mustn't be applied again by the target sampler
+    if ( isRenderEnabled )
+    {
+        for ( int i = 0; i < envelopes.attackValues.size(); i++ )
+        {
+            envelopes.attackValues[ i ] = 0.0;
         }
     }
 
     // Export Hydrogen drumkit
     if ( isSuccessful && isExportTypeH2Drumkit )
     {
-        SamplerAudioSource::EnvelopeSettings envelopes;
+        // The kit's directory, drumkit.xml and the encoded slices are streamed into the archive in one pass
+        TarGzWriter tarGzWriter( File( outputDir.absoluteFilePath( fileName + ".h2drumkit" ).toLocal8Bit().data() ) );
+        const String kitDirName = String::fromUTF8( fileName.toUtf8().constData() );
 
-        m_samplerAudioSource->getEnvelopeSettings( envelopes );
+        isSuccessful = ! tarGzWriter.failedToOpen() && tarGzWriter.addDirectory( kitDirName );
+
+        if ( isSuccessful )
+        {
+            MemoryOutputStream xmlStream;
+            TextFileHandler::writeH2DrumkitXml( xmlStream, fileName, audioFileNames, envelopes );
+
+            isSuccessful = tarGzWriter.addFile( kitDirName + "/drumkit.xml", xmlStream.getData(), xmlStream.getDataSize() );
+        }
 
-        TextFileHandler::createH2DrumkitXmlFile( samplesDirPath, fileName, audioFileNames, envelopes );
-#ifdef LINUX
-        const QString cdCommand  = "cd '" + outputDirPath + "'";
-        const QString tarCommand = "tar --create --gzip --file '" + fileName + ".h2drumkit' '" + fileName + "'";
+        for ( int i = 0; i < audioFileNames.size() && isSuccessful; i++ )
+        {
+            const MemoryBlock& encodedData = sliceExporter.getEncodedData( i );
+
+            isSuccessful = tarGzWriter.addFile( kitDirName + "/" + String::fromUTF8( audioFileNames.at( i ).toUtf8().constData() ),
+                                                encodedData.getData(),
+                                                encodedData.getSize() );
+        }
 
-        const QString command = cdCommand + " && " + tarCommand;
+        isSuccessful = isSuccessful && tarGzWriter.finish();
 
-        system( command.toLocal8Bit().data() );
-#endif
-        File( samplesDirPath.toLocal8Bit().data() ).deleteRecursively();
+        if ( ! isSuccessful )
+        {
+            errorTitle = tr("Couldn't export drumkit");
+            errorInfo = tr("An error occurred while writing the Hydrogen drumkit file");
+        }
     }
     // Export SFZ
     else if ( isSuccessful && isExportTypeSFZ )
     {
-        SamplerAudioSource::EnvelopeSettings envelopes;
-
-        m_samplerAudioSource->getEnvelopeSettings( envelopes );
-
         const QString sfzFilePath = outputDir.absoluteFilePath( fileName + ".sfz" );
         const QString samplesDirName = QFileInfo( samplesDirPath ).fileName();
 
-        TextFileHandler::createSFZFile( sfzFilePath, samplesDirName, audioFileNames, m_sampleBufferList, m_sampleHeader->sampleRate, envelopes );
+        TextFileHandler::createSFZFile( sfzFilePath, samplesDirName, audioFileNames, exportedSampleBuffers, m_sampleHeader->sampleRate, envelopes );
     }
     // Export Akai PGM
     else if ( isSuccessful && isExportTypeAkaiPgm )
     {
-        SamplerAudioSource::EnvelopeSettings envelopes;
-
-        m_samplerAudioSource->getEnvelopeSettings( envelopes );
-
         const int modelID = m_exportDialog->getAkaiModelID();
 
         const bool isVoiceOverlapMono = m_exportDialog->isVoiceOverlapMono();
@@ -597,7 +821,8 @@ void MainWindow::exportAs( const QString tempDirPath,
     // Export MIDI file
     if ( isSuccessful && isExportTypeMidiFile )
     {
-        const qreal bpm = m_ui->doubleSpinBox_OriginalBPM->value();
+        // Stretched slices play at the new tempo
+        const qreal bpm = isTimeStretchRendered ? m_ui->doubleSpinBox_NewBPM->value() : m_ui->doubleSpinBox_OriginalBPM->value();
         const ConfirmBpmDialog::TimeSigNumerator numerator = (ConfirmBpmDialog::TimeSigNumerator) m_ui->comboBox_TimeSigNumerator->currentIndex();
         const ConfirmBpmDialog::TimeSigDenominator denominator = (ConfirmBpmDialog::TimeSigDenominator) m_ui->comboBox_TimeSigDenominator->currentIndex();
 
@@ -617,20 +842,83 @@ void MainWindow::exportAs( const QString tempDirPath,
 
             if ( isExportTypeAkaiPgm )
             {
-                MidiFileHandler::SaveMidiFile( fileName, samplesDirPath, m_sampleBufferList, numSamplesToExport, m_sampleHeader->sampleRate, bpm, timeSigNumerator, timeSigDenominator, type );
+                MidiFileHandler::SaveMidiFile( fileName, samplesDirPath, exportedSampleBuffers, numSamplesToExport, m_sampleHeader->sampleRate, bpm, timeSigNumerator, timeSigDenominator, type );
             }
             else
             {
-                MidiFileHandler::SaveMidiFile( fileName, outputDirPath, m_sampleBufferList, numSamplesToExport, m_sampleHeader->sampleRate, bpm, timeSigNumerator, timeSigDenominator, type );
+                MidiFileHandler::SaveMidiFile( fileName, outputDirPath, exportedSampleBuffers, numSamplesToExport, m_sampleHeader->sampleRate, bpm, timeSigNumerator, timeSigDenominator, type );
             }
         }
     }
 
     QApplication::restoreOverrideCursor();
 
-    if ( ! isSuccessful )
+    if ( ! isSuccessful && ! isCancelled )
     {
-        MessageBoxes::showWarningDialog( m_fileHandler.getLastErrorTitle(), m_fileHandler.getLastErrorInfo() );
+        MessageBoxes::showWarningDialog( errorTitle, errorInfo );
+    }
+}
+
+
+
+void MainWindow::bounce( const QString filePath )
+{
+    waitForSampleBuffers();
+
+    OfflineBouncer::Settings settings;
+
+    settings.isMonophonic = m_ui->actionMonophonic->isChecked();
+    m_samplerAudioSource->getEnvelopeSettings( settings.envelopes );
+
+    for ( int i = 0; i < m_sampleBufferList.size(); i++ )
+    {
+        settings.outputPairNums << m_samplerAudioSource->getOutputPairNum( i );
+    }
+
+    // Stretch the same way as playback; in offline time stretch mode the samples have already been stretched
+    if ( m_rubberbandAudioSource != NULL )
+    {
+        const int startMidiNote = m_samplerAudioSource->getLowestAssignedMidiNote();
+
+        settings.isTimeStretchEnabled = true;
+        settings.stretcherOptions = m_optionsDialog->getStretcherOptions();
+
+        if ( m_ui->checkBox_TimeStretch->isChecked() )
+        {
+            settings.globalTimeRatio = m_ui->doubleSpinBox_OriginalBPM->value() / m_ui->doubleSpinBox_NewBPM->value();
+            settings.isPitchCorrectionEnabled = m_ui->checkBox_PitchCorrection->isChecked();
+        }
+
+        for ( int i = 0; i < m_sampleBufferList.size(); i++ )
+        {
+            settings.noteTimeRatios << m_rubberbandAudioSource->getNoteTimeRatio( startMidiNote + i );
+        }
+    }
+
+    // The stems are written to disk by the bouncing thread as they're rendered
+    OfflineBouncer bouncer( m_sampleBufferList, m_sampleHeader->sampleRate, settings, filePath );
+    bouncer.start();
+
+    QProgressDialog progressDialog( tr("Bouncing..."), tr("Cancel"), 0, bouncer.getNumFramesToBounce(), this );
+    progressDialog.setWindowModality( Qt::WindowModal );
+    progressDialog.setMinimumDuration( 500 );
+
+    while ( ! bouncer.wait( 50 ) )
+    {
+        // Being window modal, the dialog processes events whenever its value is set
+        progressDialog.setValue( bouncer.getNumFramesBounced() );
+
+        if ( progressDialog.wasCanceled() )
+        {
+            bouncer.cancel();
+        }
+    }
+
+    progressDialog.setValue( bouncer.getNumFramesToBounce() );
+
+    if ( ! bouncer.wasSuccessful() && ! bouncer.isCancelled() )
+    {
+        MessageBoxes::showWarningDialog( bouncer.getErrorTitle(), bouncer.getErrorInfo() );
     }
 }
 
@@ -841,7 +1129,7 @@ void MainWindow::exportAsDialog()
         return;
     }
 
-    if ( isExportTypeAudioFiles && QFileInfo( samplesDirPath ).exists() )
+    if ( isExportTypeAudioFiles && ! isExportTypeH2Drumkit && QFileInfo( samplesDirPath ).exists() )
     {
         if ( isOverwriteEnabled )
         {
@@ -906,6 +1194,20 @@ void MainWindow::exportAsDialog()
 
 
 
+void MainWindow::bounceDialog()
+{
+    const QString filter = tr("WAV File") + " (*.wav)";
+    const QString filePath = QFileDialog::getSaveFileName( this, tr("Bounce"), m_lastOpenedProjDir, filter );
+
+    // If user didn't click "Cancel"
+    if ( ! filePath.isEmpty() )
+    {
+        bounce( filePath );
+    }
+}
+
+
+
 void MainWindow::addPathToRecentProjects( QString filePath )
 {
     TextFileHandler::PathsConfig config;
@@ -0,0 +1,275 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "offlinebouncer.h"
+#include "rubberbandaudiosource.h"
+#include "samplekernels.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+
+
+//==================================================================================================
+// Public:
+
+OfflineBouncer::OfflineBouncer( const QList<SharedSampleBuffer> sampleBufferList,
+                                const int sampleRate,
+                                const Settings& settings,
+                                const QString filePath ) :
+    QThread(),
+    m_sampleBufferList( sampleBufferList ),
+    m_sampleRate( sampleRate ),
+    m_settings( settings ),
+    m_numSequenceFrames( 0 ),
+    m_isCancelled( 0 ),
+    m_numFramesBounced( 0 ),
+    m_interleavedBlock( BLOCK_SIZE * 2 ),
+    m_isSuccessful( false )
+{
+    int numOutputPairs = 1;
+
+    foreach ( int outputPairNum, settings.outputPairNums )
+    {
+        numOutputPairs = qMax( numOutputPairs, outputPairNum + 1 );
+    }
+
+    const QFileInfo fileInfo( filePath );
+    const QDir dir = fileInfo.absoluteDir();
+
+    for ( int outputPairNum = 0; outputPairNum < numOutputPairs; outputPairNum++ )
+    {
+        QString fileBaseName = fileInfo.completeBaseName();
+
+        if ( numOutputPairs > 1 )
+        {
+            fileBaseName += outputPairNum == 0 ? "_out" : "_out_" + QString::number( outputPairNum + 1 );
+        }
+
+        m_stemFilePaths << dir.absoluteFilePath( fileBaseName + ".wav" );
+    }
+
+    // Length of the sequence once each sample has been stretched by its note's time ratio
+    qreal numSequenceFrames = 0.0;
+
+    for ( int i = 0; i < sampleBufferList.size(); i++ )
+    {
+        qreal timeRatio = 1.0;
+
+        if ( settings.isTimeStretchEnabled )
+        {
+            timeRatio = settings.globalTimeRatio * settings.noteTimeRatios.at( i );
+        }
+
+        numSequenceFrames += sampleBufferList.at( i )->getNumFrames() * timeRatio;
+    }
+
+    m_numSequenceFrames = roundToInt( numSequenceFrames );
+}
+
+
+
+OfflineBouncer::~OfflineBouncer()
+{
+    cancel();
+    wait();
+}
+
+
+
+//==================================================================================================
+// Protected:
+
+void OfflineBouncer::run()
+{
+    const int numChans = getNumOutputPairs() * 2;
+
+    if ( ! openStemFiles() )
+    {
+        closeStemFiles();
+        return;
+    }
+
+    SamplerAudioSource sampler( m_settings.isMonophonic );
+
+    sampler.setSamples( m_sampleBufferList, m_sampleRate );
+    sampler.setEnvelopeSettings( m_settings.envelopes );
+
+    for ( int i = 0; i < m_settings.outputPairNums.size(); i++ )
+    {
+        sampler.setOutputPair( i, m_settings.outputPairNums.at( i ) );
+    }
+
+    // Must be deleted before the sampler
+    ScopedPointer<RubberbandAudioSource> stretcher;
+    AudioSource* source = &sampler;
+
+    if ( m_settings.isTimeStretchEnabled )
+    {
+        stretcher = new RubberbandAudioSource( &sampler, numChans, m_settings.stretcherOptions );
+
+        stretcher->setGlobalTimeRatio( m_settings.globalTimeRatio );
+        stretcher->enablePitchCorrection( m_settings.isPitchCorrectionEnabled );
+
+        for ( int i = 0; i < m_settings.noteTimeRatios.size(); i++ )
+        {
+            stretcher->setNoteTimeRatio( sampler.getLowestAssignedMidiNote() + i, m_settings.noteTimeRatios.at( i ) );
+        }
+
+        source = stretcher;
+    }
+
+    // Playing back at the samples' own rate means the sampler never has to resample
+    source->prepareToPlay( BLOCK_SIZE, m_sampleRate );
+
+    AudioSampleBuffer block( numChans, BLOCK_SIZE );
+    const AudioSourceChannelInfo info( &block, 0, BLOCK_SIZE );
+
+    const int64 maxNumOutputFrames = m_numSequenceFrames + (int64) m_sampleRate * MAX_TAIL_SECS;
+    const float silenceThreshold = Decibels::decibelsToGain( -96.0f );
+
+    // The stretcher delays its output, by an amount that's only known once the first block has set the time ratio
+    int numLatencyFrames = stretcher != nullptr ? -1 : 0;
+    int64 numOutputFrames = 0;
+    bool isFinished = false;
+
+    sampler.playAll();
+
+    while ( ! isFinished && ! isCancelled() )
+    {
+        source->getNextAudioBlock( info );
+
+        if ( numLatencyFrames < 0 )
+        {
+            numLatencyFrames = stretcher->getLatency();
+        }
+
+        const int numFramesToSkip = jmin( numLatencyFrames, BLOCK_SIZE );
+        numLatencyFrames -= numFramesToSkip;
+
+        // Once the whole sequence has been bounced, carry on until the releases and the stretcher have died away
+        if ( numOutputFrames >= m_numSequenceFrames )
+        {
+            isFinished = block.getMagnitude( 0, BLOCK_SIZE ) < silenceThreshold || numOutputFrames >= maxNumOutputFrames;
+        }
+
+        if ( ! isFinished )
+        {
+            if ( ! writeToStemFiles( block, numFramesToSkip, BLOCK_SIZE - numFramesToSkip ) )
+            {
+                break;
+            }
+
+            numOutputFrames += BLOCK_SIZE - numFramesToSkip;
+
+            m_numFramesBounced = (int) jmin( numOutputFrames, (int64) m_numSequenceFrames );
+        }
+    }
+
+    source->releaseResources();
+
+    closeStemFiles();
+}
+
+
+
+//==================================================================================================
+// Private:
+
+bool OfflineBouncer::openStemFiles()
+{
+    // RF64 falls back to a plain WAV header when the file is small enough, so a long bounce isn't cut off at 4 GB
+    SF_INFO sfInfo;
+    memset( &sfInfo, 0, sizeof( SF_INFO ) );
+
+    sfInfo.samplerate = m_sampleRate;
+    sfInfo.channels   = 2;
+    sfInfo.format     = SF_FORMAT_RF64 | SF_FORMAT_FLOAT;
+
+    Q_ASSERT( sf_format_check( &sfInfo ) );
+
+    foreach ( QString filePath, m_stemFilePaths )
+    {
+        SNDFILE* const fileID = sf_open( filePath.toLocal8Bit().data(), SFM_WRITE, &sfInfo );
+
+        if ( fileID == NULL )
+        {
+            m_errorTitle = "Couldn't open file for writing";
+            m_errorInfo = sf_strerror( NULL );
+            return false;
+        }
+
+        sf_command( fileID, SFC_RF64_AUTO_DOWNGRADE, NULL, SF_TRUE );
+
+        m_stemFiles.add( fileID );
+    }
+
+    return true;
+}
+
+
+
+bool OfflineBouncer::writeToStemFiles( const AudioSampleBuffer& block, const int startFrame, const int numFrames )
+{
+    for ( int outputPairNum = 0; outputPairNum < m_stemFiles.size(); outputPairNum++ )
+    {
+        const float* const input[] = { block.getReadPointer( outputPairNum * 2, startFrame ),
+                                       block.getReadPointer( outputPairNum * 2 + 1, startFrame ) };
+
+        SampleKernels::interleave( input, 2, numFrames, m_interleavedBlock );
+
+        if ( sf_writef_float( m_stemFiles[ outputPairNum ], m_interleavedBlock, numFrames ) != numFrames )
+        {
+            m_errorTitle = "Couldn't write bounced audio";
+            m_errorInfo = sf_strerror( m_stemFiles[ outputPairNum ] );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+void OfflineBouncer::closeStemFiles()
+{
+    m_isSuccessful = m_errorTitle.isEmpty() && ! isCancelled();
+
+    foreach ( SNDFILE* fileID, m_stemFiles )
+    {
+        if ( m_isSuccessful )
+        {
+            sf_write_sync( fileID );
+        }
+
+        sf_close( fileID );
+    }
+
+    // Don't leave incomplete stems behind
+    if ( ! m_isSuccessful )
+    {
+        for ( int i = 0; i < m_stemFiles.size(); i++ )
+        {
+            QFile::remove( m_stemFilePaths.at( i ) );
+        }
+    }
+
+    m_stemFiles.clear();
+}
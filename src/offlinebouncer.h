@@ -0,0 +1,132 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef OFFLINEBOUNCER_H
+#define OFFLINEBOUNCER_H
+
+#include <QThread>
+#include <QStringList>
+#include "JuceHeader.h"
+#include "samplebuffer.h"
+#include "sampleraudiosource.h"
+#include <rubberband/RubberBandStretcher.h>
+#include <sndfile.h>
+
+using namespace RubberBand;
+
+
+// Renders the "play all" sequence to disk on a background thread, as fast as the CPU allows. The same
+// SamplerAudioSource -> RubberbandAudioSource chain that's used for playback is driven block by block, but the
+// bouncer builds its own instances so the chain attached to the audio device is left alone. Each output pair
+// is bounced to its own stereo stem file, and each block is written out as soon as it has been rendered, so
+// the length of a bounce isn't limited by memory
+
+class OfflineBouncer : public QThread
+{
+public:
+    struct Settings
+    {
+        Settings() :
+            isMonophonic( false ),
+            isTimeStretchEnabled( false ),
+            stretcherOptions( RubberBandStretcher::DefaultOptions ),
+            globalTimeRatio( 1.0 ),
+            isPitchCorrectionEnabled( true )
+        {
+        }
+
+        bool isMonophonic;
+        SamplerAudioSource::EnvelopeSettings envelopes;
+        QList<int> outputPairNums;                      // One per sample
+
+        // Real-time time stretch; when disabled the remaining settings are ignored
+        bool isTimeStretchEnabled;
+        RubberBandStretcher::Options stretcherOptions;
+        qreal globalTimeRatio;
+        bool isPitchCorrectionEnabled;
+        QList<qreal> noteTimeRatios;                    // One per sample
+    };
+
+    // The stems are written as 32-bit float WAV files, so that output pairs mixed above full scale don't clip, and
+    // switch to RF64 if they grow beyond 4 GB. They're named after "filePath", or if there's more than one output
+    // pair, after its JACK output port: "name_out.wav", "name_out_2.wav", "name_out_3.wav"...
+    OfflineBouncer( QList<SharedSampleBuffer> sampleBufferList, int sampleRate, const Settings& settings, QString filePath );
+
+    // Stops the bounce if it's still running
+    ~OfflineBouncer();
+
+    // Stop bouncing as soon as the current block is done. Any stem files already started are deleted
+    void cancel()                                   { m_isCancelled = 1; }
+    bool isCancelled() const                        { return m_isCancelled.get() != 0; }
+
+    // Progress, in frames at the sample rate of the samples. The tail after the sequence isn't counted
+    int getNumFramesToBounce() const                { return m_numSequenceFrames; }
+    int getNumFramesBounced() const                 { return m_numFramesBounced.get(); }
+
+    int getNumOutputPairs() const                   { return m_stemFilePaths.size(); }
+
+    // One per output pair
+    QStringList getStemFilePaths() const            { return m_stemFilePaths; }
+
+    // Only valid once the thread has finished. If a stem file couldn't be written, none of them are kept
+    bool wasSuccessful() const                      { return m_isSuccessful; }
+    QString getErrorTitle() const                   { return m_errorTitle; }
+    QString getErrorInfo() const                    { return m_errorInfo; }
+
+    // Size of the blocks pulled through the audio source chain
+    static const int BLOCK_SIZE = 1024;
+
+    // Longest tail bounced after the end of the sequence, in case it never falls silent
+    static const int MAX_TAIL_SECS = 10;
+
+protected:
+    void run();
+
+private:
+    bool openStemFiles();
+
+    // Write "numFrames" frames of "block", starting at "startFrame", to the stem files
+    bool writeToStemFiles( const AudioSampleBuffer& block, int startFrame, int numFrames );
+
+    void closeStemFiles();
+
+    const QList<SharedSampleBuffer> m_sampleBufferList;
+    const int m_sampleRate;
+    const Settings m_settings;
+
+    QStringList m_stemFilePaths;
+    int m_numSequenceFrames;
+
+    Atomic<int> m_isCancelled;
+    Atomic<int> m_numFramesBounced;
+
+    // Only accessed by the bouncing thread until it has finished
+    Array<SNDFILE*> m_stemFiles;
+    HeapBlock<float> m_interleavedBlock;
+    bool m_isSuccessful;
+    QString m_errorTitle;
+    QString m_errorInfo;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( OfflineBouncer )
+};
+
+
+#endif // OFFLINEBOUNCER_H
@@ -36,8 +36,9 @@ int OfflineTimeStretcher::stretch( const SharedSampleBuffer sampleBuffer,
 {
     RubberBandStretcher stretcher( sampleRate, numChans, options, timeRatio, pitchScale );
 
-    // Copy sample buffer to a temporary buffer
-    SharedSampleBuffer tempBuffer( new SampleBuffer( *sampleBuffer.data() ) );
+    // Keep hold of the original sample data by creating a view onto it; the sample buffer is given
+    // new storage below, so nothing needs to be copied unless the buffer's size remains the same
+    SharedSampleBuffer tempBuffer( new SampleBuffer( *sampleBuffer.data(), 0, sampleBuffer->getNumFrames() ) );
 
     const int origNumFrames = tempBuffer->getNumFrames();
     const int newBufferSize = roundToIntAccurate( origNumFrames * timeRatio );
@@ -51,6 +52,7 @@ int OfflineTimeStretcher::stretch( const SharedSampleBuffer sampleBuffer,
     stretcher.setExpectedInputDuration( origNumFrames );
 
     sampleBuffer->setSize( numChans, newBufferSize );
+    sampleBuffer->detach();
 
     for ( int chanNum = 0; chanNum < numChans; chanNum++ )
     {
@@ -38,7 +38,8 @@ OptionsDialog::OptionsDialog( AudioDeviceManager& deviceManager, QWidget* parent
     QDialog( parent ),
     m_ui( new Ui::OptionsDialog ),
     m_deviceManager( deviceManager ),
-    m_stretcherOptions( RubberBandStretcher::DefaultOptions )
+    m_stretcherOptions( RubberBandStretcher::DefaultOptions ),
+    m_projectStorage( AudioFileHandler::STORE_WAV_FAST )
 {
     // Setup user interface
     m_ui->setupUi( this );
@@ -66,6 +67,7 @@ OptionsDialog::OptionsDialog( AudioDeviceManager& deviceManager, QWidget* parent
 
     // Paths
     setTempDirPath();
+    setProjectStorage();
 }
 
 
@@ -335,6 +337,22 @@ void OptionsDialog::setTempDirPath()
 
 
 
+void OptionsDialog::setProjectStorage()
+{
+    TextFileHandler::PathsConfig config;
+
+    TextFileHandler::readPathsConfigFile( config );
+
+    if ( config.projectStorage >= 0 && config.projectStorage < m_ui->comboBox_ProjectStorage->count() )
+    {
+        m_projectStorage = static_cast<AudioFileHandler::ProjectStorage>( config.projectStorage );
+    }
+
+    m_ui->comboBox_ProjectStorage->setCurrentIndex( m_projectStorage );
+}
+
+
+
 void OptionsDialog::updateAudioDeviceComboBox()
 {
     AudioIODeviceType* const audioBackendType = m_deviceManager.getCurrentDeviceTypeObject();
@@ -638,6 +656,9 @@ void OptionsDialog::saveConfig()
 
     config.tempDirPath = m_ui->lineEdit_TempDir->text();
 
+    m_projectStorage = static_cast<AudioFileHandler::ProjectStorage>( m_ui->comboBox_ProjectStorage->currentIndex() );
+    config.projectStorage = m_projectStorage;
+
     TextFileHandler::createPathsConfigFile( config );
 }
 
@@ -700,6 +721,8 @@ void OptionsDialog::reject()
     tempDir.cdUp();
     m_ui->lineEdit_TempDir->setText( tempDir.absolutePath() );
 
+    m_ui->comboBox_ProjectStorage->setCurrentIndex( m_projectStorage );
+
     QDialog::reject();
 }
 
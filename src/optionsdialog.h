@@ -31,6 +31,7 @@
 #include "JuceHeader.h"
 #include "simplesynth.h"
 #include "directoryvalidator.h"
+#include "audiofilehandler.h"
 
 using namespace RubberBand;
 
@@ -72,6 +73,8 @@ public:
     // it is valid and writable, otherwise returns an empty string
     QString getTempDirPath() const                              { return m_tempDirPath; }
 
+    AudioFileHandler::ProjectStorage getProjectStorage() const  { return m_projectStorage; }
+
 protected:
     void changeEvent( QEvent* event );
     void showEvent( QShowEvent* event );
@@ -79,6 +82,7 @@ protected:
 
 private:
     void setTempDirPath();
+    void setProjectStorage();
 
     void updateAudioDeviceComboBox();
     void updateOutputChannelComboBox();
@@ -110,6 +114,8 @@ private:
 
     QString m_tempDirPath;
 
+    AudioFileHandler::ProjectStorage m_projectStorage;
+
 private:
     static String getNameForChannelPair( const String& name1, const String& name2 );
     static QString getNoDeviceString() { return "<< " + tr("none") + " >>"; }
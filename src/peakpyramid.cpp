@@ -0,0 +1,338 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "peakpyramid.h"
+#include <QThreadPool>
+#include <QRunnable>
+
+
+//==================================================================================================
+
+// Builds a peak pyramid a chunk at a time on one of the global thread pool's threads
+
+class PeakPyramidBuilder : public QRunnable
+{
+public:
+    PeakPyramidBuilder( const PeakPyramid::Ptr peaks ) :
+        m_peaks( peaks )
+    {
+    }
+
+    void run()
+    {
+        while ( m_peaks->buildNextChunk() )
+        {
+        }
+    }
+
+private:
+    const PeakPyramid::Ptr m_peaks;
+};
+
+
+
+//==================================================================================================
+// Public:
+
+PeakPyramid::PeakPyramid( const float* const* const sampleData, const int numChans, const int numFrames ) :
+    m_sampleData( sampleData ),
+    m_numChans( numChans ),
+    m_numFrames( numFrames ),
+    m_isCancelled( false )
+{
+    // Finest level; the last block may be shorter than the others
+    int numBlocks = ( numFrames + BASE_BLOCK_SIZE - 1 ) / BASE_BLOCK_SIZE;
+
+    if ( numBlocks <= 1 )
+    {
+        // Nothing to build - ranges this short are always scanned directly
+        m_numFramesReady.set( numFrames );
+        return;
+    }
+
+    m_levels.add( new Level( numChans, numBlocks ) );
+
+    while ( numBlocks > LEVEL_FACTOR )
+    {
+        numBlocks = ( numBlocks + LEVEL_FACTOR - 1 ) / LEVEL_FACTOR;
+        m_levels.add( new Level( numChans, numBlocks ) );
+    }
+}
+
+
+
+void PeakPyramid::startBuilding()
+{
+    if ( ! isComplete() )
+    {
+        QThreadPool::globalInstance()->start( new PeakPyramidBuilder( this ) );
+    }
+}
+
+
+
+void PeakPyramid::cancel()
+{
+    const ScopedLock lock( m_buildLock );
+
+    m_isCancelled = true;
+}
+
+
+
+bool PeakPyramid::buildNextChunk()
+{
+    const ScopedLock lock( m_buildLock );
+
+    if ( m_isCancelled || isComplete() )
+    {
+        return false;
+    }
+
+    const int startFrame = m_numFramesReady.get();
+    const int endFrame = jmin( startFrame + CHUNK_SIZE, m_numFrames );
+
+    // Add the chunk to the finest level
+    Level* const level = m_levels.getFirst();
+
+    const int endBlock = ( endFrame == m_numFrames ) ? level->numBlocks : endFrame / BASE_BLOCK_SIZE;
+
+    for ( int chanNum = 0; chanNum < m_numChans; chanNum++ )
+    {
+        for ( int blockNum = level->numBlocksBuilt; blockNum < endBlock; blockNum++ )
+        {
+            const int blockStartFrame = blockNum * BASE_BLOCK_SIZE;
+            const int blockSize = jmin( BASE_BLOCK_SIZE, m_numFrames - blockStartFrame );
+
+            const Range<float> range = FloatVectorOperations::findMinAndMax( m_sampleData[ chanNum ] + blockStartFrame,
+                                                                             blockSize );
+
+            level->minValues[ chanNum * level->numBlocks + blockNum ] = range.getStart();
+            level->maxValues[ chanNum * level->numBlocks + blockNum ] = range.getEnd();
+        }
+    }
+
+    level->numBlocksBuilt = endBlock;
+
+    buildCoarserLevels();
+
+    m_numFramesReady.set( endFrame );
+
+    return endFrame < m_numFrames;
+}
+
+
+
+void PeakPyramid::writeToStream( OutputStream& stream )
+{
+    // Finish building the pyramid on this thread if the worker thread hasn't got to it yet
+    while ( buildNextChunk() )
+    {
+    }
+
+    jassert( isComplete() );
+
+    stream.writeInt( FILE_MAGIC_NUMBER );
+    stream.writeInt( FILE_VERSION );
+    stream.writeInt( m_numChans );
+    stream.writeInt( m_numFrames );
+    stream.writeInt( BASE_BLOCK_SIZE );
+
+    // Only the finest level is stored; the others are quick to rebuild from it
+    if ( ! m_levels.isEmpty() )
+    {
+        const Level* const level = m_levels.getFirst();
+
+        for ( int i = 0; i < m_numChans * level->numBlocks; i++ )
+        {
+            stream.writeFloat( level->minValues[ i ] );
+            stream.writeFloat( level->maxValues[ i ] );
+        }
+    }
+}
+
+
+
+bool PeakPyramid::readFromStream( InputStream& stream )
+{
+    const ScopedLock lock( m_buildLock );
+
+    jassert( m_numFramesReady.get() == 0 || m_levels.isEmpty() );
+
+    if ( stream.readInt() != FILE_MAGIC_NUMBER ||
+         stream.readInt() != FILE_VERSION ||
+         stream.readInt() != m_numChans ||
+         stream.readInt() != m_numFrames ||
+         stream.readInt() != BASE_BLOCK_SIZE )
+    {
+        return false;
+    }
+
+    if ( ! m_levels.isEmpty() )
+    {
+        Level* const level = m_levels.getFirst();
+
+        if ( stream.getNumBytesRemaining() < (int64) m_numChans * level->numBlocks * 2 * sizeof( float ) )
+        {
+            return false;
+        }
+
+        for ( int i = 0; i < m_numChans * level->numBlocks; i++ )
+        {
+            level->minValues[ i ] = stream.readFloat();
+            level->maxValues[ i ] = stream.readFloat();
+        }
+
+        level->numBlocksBuilt = level->numBlocks;
+
+        buildCoarserLevels();
+    }
+
+    m_numFramesReady.set( m_numFrames );
+
+    return true;
+}
+
+
+
+bool PeakPyramid::isReady( const int startFrame, const int numFrames ) const
+{
+    return numFrames < BASE_BLOCK_SIZE * 2 || startFrame + numFrames <= m_numFramesReady.get();
+}
+
+
+
+Range<float> PeakPyramid::getMinMax( const int chanNum, const int startFrame, const int numFrames ) const
+{
+    jassert( chanNum >= 0 && chanNum < m_numChans );
+    jassert( startFrame >= 0 && startFrame + numFrames <= m_numFrames );
+
+    const float* const sampleData = m_sampleData[ chanNum ];
+
+    // Short ranges are quicker to scan directly
+    if ( m_levels.isEmpty() || numFrames < BASE_BLOCK_SIZE * 2 || ! isReady( startFrame, numFrames ) )
+    {
+        return FloatVectorOperations::findMinAndMax( sampleData + startFrame, numFrames );
+    }
+
+    const int endFrame = startFrame + numFrames;
+
+    // Blocks of the finest level that lie entirely within the range; the last block is
+    // included if the range extends to the end of the sample data
+    int startBlock = ( startFrame + BASE_BLOCK_SIZE - 1 ) / BASE_BLOCK_SIZE;
+    int endBlock = ( endFrame == m_numFrames ) ? m_levels.getFirst()->numBlocks : endFrame / BASE_BLOCK_SIZE;
+
+    // Scan the frames either side of these blocks; the first frame is always scanned so the range is never empty
+    const int headEndFrame = jmax( startBlock * BASE_BLOCK_SIZE, startFrame + 1 );
+    const int tailStartFrame = jmin( endBlock * BASE_BLOCK_SIZE, endFrame );
+
+    Range<float> range = FloatVectorOperations::findMinAndMax( sampleData + startFrame, headEndFrame - startFrame );
+
+    if ( tailStartFrame < endFrame )
+    {
+        range = range.getUnionWith( FloatVectorOperations::findMinAndMax( sampleData + tailStartFrame, endFrame - tailStartFrame ) );
+    }
+
+    float minValue = range.getStart();
+    float maxValue = range.getEnd();
+
+    // Work up through the levels, adding blocks that don't line up with the next level's blocks
+    for ( int levelNum = 0; startBlock < endBlock; levelNum++ )
+    {
+        const Level* const level = m_levels.getUnchecked( levelNum );
+        const Level* const nextLevel = m_levels[ levelNum + 1 ];
+
+        if ( nextLevel == nullptr )
+        {
+            addBlocks( level, chanNum, startBlock, endBlock, minValue, maxValue );
+            break;
+        }
+
+        const int nextStartBlock = ( startBlock + LEVEL_FACTOR - 1 ) / LEVEL_FACTOR;
+        const int nextEndBlock = ( endBlock == level->numBlocks ) ? nextLevel->numBlocks : endBlock / LEVEL_FACTOR;
+
+        if ( nextStartBlock >= nextEndBlock )
+        {
+            addBlocks( level, chanNum, startBlock, endBlock, minValue, maxValue );
+            break;
+        }
+
+        addBlocks( level, chanNum, startBlock, nextStartBlock * LEVEL_FACTOR, minValue, maxValue );
+        addBlocks( level, chanNum, jmin( nextEndBlock * LEVEL_FACTOR, endBlock ), endBlock, minValue, maxValue );
+
+        startBlock = nextStartBlock;
+        endBlock = nextEndBlock;
+    }
+
+    return Range<float>( minValue, maxValue );
+}
+
+
+
+//==================================================================================================
+// Private:
+
+void PeakPyramid::buildCoarserLevels()
+{
+    for ( int levelNum = 1; levelNum < m_levels.size(); levelNum++ )
+    {
+        const Level* const prevLevel = m_levels.getUnchecked( levelNum - 1 );
+        Level* const level = m_levels.getUnchecked( levelNum );
+
+        const int numBlocksToBuild = ( prevLevel->numBlocksBuilt == prevLevel->numBlocks ) ?
+                                     level->numBlocks : prevLevel->numBlocksBuilt / LEVEL_FACTOR;
+
+        for ( int chanNum = 0; chanNum < m_numChans; chanNum++ )
+        {
+            for ( int blockNum = level->numBlocksBuilt; blockNum < numBlocksToBuild; blockNum++ )
+            {
+                const int startBlock = blockNum * LEVEL_FACTOR;
+                const int endSubBlock = jmin( startBlock + LEVEL_FACTOR, prevLevel->numBlocks );
+
+                float minValue = prevLevel->minValues[ chanNum * prevLevel->numBlocks + startBlock ];
+                float maxValue = prevLevel->maxValues[ chanNum * prevLevel->numBlocks + startBlock ];
+
+                addBlocks( prevLevel, chanNum, startBlock + 1, endSubBlock, minValue, maxValue );
+
+                level->minValues[ chanNum * level->numBlocks + blockNum ] = minValue;
+                level->maxValues[ chanNum * level->numBlocks + blockNum ] = maxValue;
+            }
+        }
+
+        level->numBlocksBuilt = numBlocksToBuild;
+    }
+}
+
+
+
+void PeakPyramid::addBlocks( const Level* const level, const int chanNum, const int startBlock, const int endBlock,
+                             float& minValue, float& maxValue ) const
+{
+    const float* const minValues = level->minValues + chanNum * level->numBlocks;
+    const float* const maxValues = level->maxValues + chanNum * level->numBlocks;
+
+    for ( int blockNum = startBlock; blockNum < endBlock; blockNum++ )
+    {
+        minValue = jmin( minValue, minValues[ blockNum ] );
+        maxValue = jmax( maxValue, maxValues[ blockNum ] );
+    }
+}
@@ -0,0 +1,118 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef PEAKPYRAMID_H
+#define PEAKPYRAMID_H
+
+#include "JuceHeader.h"
+
+
+// Min/max sample values over blocks of frames at several resolutions, each level's blocks being LEVEL_FACTOR
+// times the size of the level below. Finding the peaks in a range of frames only needs to combine a handful of
+// blocks from the coarsest levels that fit, plus a short scan of the raw sample data at either end.
+// The pyramid is built on a worker thread from the start of the sample data to the end, and ranges can be
+// looked up as soon as the frames they cover are ready
+
+class PeakPyramid : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<PeakPyramid> Ptr;
+
+    // "sampleData" must remain valid until the pyramid is complete or cancel() has been called
+    PeakPyramid( const float* const* sampleData, int numChans, int numFrames );
+
+    // Queue the pyramid to be built on a worker thread
+    void startBuilding();
+
+    // Stop building the pyramid; once this returns the sample data is no longer accessed by the worker thread
+    void cancel();
+
+    // Build the next chunk of frames. Returns false when there is nothing more to build
+    bool buildNextChunk();
+
+    // Write the pyramid in a compact form that can be read back without scanning the sample data.
+    // If the pyramid isn't complete then it is finished off first
+    void writeToStream( OutputStream& stream );
+
+    // Fill the pyramid from a stream written by writeToStream(). This must be done before building is started.
+    // Returns false if the stream doesn't hold a pyramid of the same dimensions
+    bool readFromStream( InputStream& stream );
+
+    // Returns true if getMinMax() can look up this range of frames without scanning all of them
+    bool isReady( int startFrame, int numFrames ) const;
+
+    bool isComplete() const                 { return m_numFramesReady.get() == m_numFrames; }
+
+    // If the range is not yet ready then the sample data is scanned directly
+    Range<float> getMinMax( int chanNum, int startFrame, int numFrames ) const;
+
+    // Size in frames of the blocks in the finest level
+    static const int BASE_BLOCK_SIZE = 64;
+
+    static const int LEVEL_FACTOR = 4;
+
+    // No. of frames built at a time on the worker thread
+    static const int CHUNK_SIZE = 65536;
+
+    static const int FILE_MAGIC_NUMBER = 0x4B415050; // "PPAK"
+    static const int FILE_VERSION = 1;
+
+private:
+    struct Level
+    {
+        Level( const int numChans, const int numBlocksPerChan ) :
+            numBlocks( numBlocksPerChan ),
+            numBlocksBuilt( 0 ),
+            minValues( numChans * numBlocksPerChan ),
+            maxValues( numChans * numBlocksPerChan )
+        {
+        }
+
+        const int numBlocks;
+        int numBlocksBuilt;
+        HeapBlock<float> minValues;
+        HeapBlock<float> maxValues;
+    };
+
+    // Build any blocks of the coarser levels whose sub-blocks are all ready
+    void buildCoarserLevels();
+
+    // Widens "minValue" and "maxValue" to include blocks "startBlock" to "endBlock" (exclusive) of a level
+    void addBlocks( const Level* level, int chanNum, int startBlock, int endBlock, float& minValue, float& maxValue ) const;
+
+    const float* const* const m_sampleData;
+    const int m_numChans;
+    const int m_numFrames;
+    OwnedArray<Level> m_levels;
+
+    // Frames before this have been added to every level of the pyramid
+    Atomic<int> m_numFramesReady;
+
+    // Held by the worker thread while it reads the sample data
+    CriticalSection m_buildLock;
+    bool m_isCancelled;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( PeakPyramid )
+};
+
+
+#endif // PEAKPYRAMID_H
@@ -0,0 +1,311 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "projectreader.h"
+#include "audiofilehandler.h"
+#include <QRunnable>
+#include <QCryptographicHash>
+#include <QFileInfo>
+
+
+//==================================================================================================
+// Decodes one audio file and its peaks into a placeholder
+
+class ProjectReader::Decoder
+{
+public:
+    Decoder( ProjectReader& reader, const int audioEntryIndex, const int peakEntryIndex, const SharedSampleBuffer placeholder ) :
+        m_reader( reader ),
+        m_audioEntryIndex( audioEntryIndex ),
+        m_peakEntryIndex( peakEntryIndex ),
+        m_sampleBuffer( placeholder )
+    {
+    }
+
+    bool decode()
+    {
+        MemoryBlock fileData;
+
+        bool isSuccessful = m_reader.readEntry( m_audioEntryIndex, fileData );
+
+        if ( isSuccessful )
+        {
+            const QByteArray hash = QCryptographicHash::hash( QByteArray::fromRawData( static_cast<const char*>( fileData.getData() ),
+                                                                                       (int) fileData.getSize() ),
+                                                              QCryptographicHash::Md5 );
+
+            isSuccessful = AudioFileHandler::decodeAudioData( fileData, m_sampleBuffer );
+
+            MemoryBlock peakData;
+
+            // Use the stored peaks if they're present and up to date
+            if ( isSuccessful && m_reader.readEntry( m_peakEntryIndex, peakData ) )
+            {
+                MemoryInputStream stream( peakData, false );
+                AudioFileHandler::loadPeakStream( stream, hash, m_sampleBuffer );
+            }
+        }
+
+        if ( ! isSuccessful )
+        {
+            m_sampleBuffer->clear();
+        }
+
+        m_sampleBuffer->setLoaded();
+
+        return isSuccessful;
+    }
+
+    uint32 getLoadRequestTime() const               { return m_sampleBuffer->getLoadRequestTime(); }
+
+private:
+    ProjectReader& m_reader;
+    const int m_audioEntryIndex;
+    const int m_peakEntryIndex;
+
+    const SharedSampleBuffer m_sampleBuffer;
+};
+
+
+
+//==================================================================================================
+// Runs decoders one after another until there are none left
+
+class ProjectReader::Worker : public QRunnable
+{
+public:
+    Worker( ProjectReader& reader ) :
+        m_reader( reader )
+    {
+    }
+
+    void run()
+    {
+        Decoder* decoder;
+
+        while ( ( decoder = m_reader.takeNextDecoder() ) != nullptr )
+        {
+            m_reader.finishDecoder( decoder->decode() );
+        }
+    }
+
+private:
+    ProjectReader& m_reader;
+};
+
+
+
+//==================================================================================================
+// Public:
+
+ProjectReader::ProjectReader( const QString zipFilePath, const QString projectName ) :
+    m_zipFile( File( zipFilePath.toLocal8Bit().data() ) ),
+    m_entryDirName( String::fromUTF8( projectName.toUtf8().constData() ) + "/" ),
+    m_isCancelled( false ),
+    m_numDecodersLeft( 0 ),
+    m_numFailedDecoders( 0 )
+{
+}
+
+
+
+ProjectReader::~ProjectReader()
+{
+    {
+        const ScopedLock lock( m_lock );
+        m_isCancelled = true;
+    }
+
+    m_threadPool.waitForDone();
+}
+
+
+
+bool ProjectReader::readProjectSettings( TextFileHandler::ProjectSettings& settings )
+{
+    MemoryBlock xmlData;
+
+    if ( ! readEntry( getEntryIndex( "shuriken.xml" ), xmlData ) )
+    {
+        return false;
+    }
+
+    MemoryInputStream stream( xmlData, false );
+
+    return TextFileHandler::readProjectXml( stream, settings );
+}
+
+
+
+bool ProjectReader::readSampleBuffers( const QStringList audioFileNames,
+                                       QList<SharedSampleBuffer>& sampleBuffers,
+                                       SharedSampleHeader& sampleHeader )
+{
+    jassert( m_decoders.isEmpty() );
+
+    sampleBuffers.clear();
+
+    if ( audioFileNames.isEmpty() )
+    {
+        return false;
+    }
+
+    // The headers give the size of every slice, which is all that's needed to lay out the slices and play them
+    foreach ( QString fileName, audioFileNames )
+    {
+        const int audioEntryIndex = getEntryIndex( fileName );
+
+        SharedSampleHeader header;
+        const SharedSampleBuffer placeholder = readAudioHeader( audioEntryIndex, header );
+
+        if ( placeholder.isNull() )
+        {
+            sampleBuffers.clear();
+            m_decoders.clear();
+            return false;
+        }
+
+        if ( sampleBuffers.isEmpty() )
+        {
+            sampleHeader = header;
+        }
+
+        sampleBuffers << placeholder;
+
+        const QString peakFileName = QFileInfo( fileName ).completeBaseName() + ".peaks";
+
+        m_decoders.add( new Decoder( *this, audioEntryIndex, getEntryIndex( peakFileName ), placeholder ) );
+    }
+
+    {
+        const ScopedLock lock( m_lock );
+
+        for ( int i = 0; i < m_decoders.size(); i++ )
+        {
+            m_pendingDecoders.add( m_decoders[ i ] );
+        }
+    }
+
+    m_numDecodersLeft = m_decoders.size();
+
+    for ( int i = 0; i < jmin( m_threadPool.maxThreadCount(), m_decoders.size() ); i++ )
+    {
+        m_threadPool.start( new Worker( *this ) );
+    }
+
+    return true;
+}
+
+
+
+bool ProjectReader::waitForSampleBuffers()
+{
+    m_threadPool.waitForDone();
+
+    return m_numFailedDecoders.get() == 0;
+}
+
+
+
+//==================================================================================================
+// Private:
+
+int ProjectReader::getEntryIndex( const QString& fileName )
+{
+    return m_zipFile.getIndexOfFileName( m_entryDirName + String::fromUTF8( fileName.toUtf8().constData() ) );
+}
+
+
+
+bool ProjectReader::readEntry( const int entryIndex, MemoryBlock& data )
+{
+    if ( entryIndex < 0 )
+    {
+        return false;
+    }
+
+    ScopedPointer<InputStream> stream( m_zipFile.createStreamForEntry( entryIndex ) );
+
+    if ( stream == nullptr )
+    {
+        return false;
+    }
+
+    const int64 numBytes = m_zipFile.getEntry( entryIndex )->uncompressedSize;
+
+    data.setSize( (size_t) numBytes );
+
+    return stream->read( data.getData(), (int) numBytes ) == numBytes;
+}
+
+
+
+SharedSampleBuffer ProjectReader::readAudioHeader( const int entryIndex, SharedSampleHeader& sampleHeader )
+{
+    ScopedPointer<InputStream> stream( entryIndex >= 0 ? m_zipFile.createStreamForEntry( entryIndex ) : nullptr );
+
+    if ( stream == nullptr )
+    {
+        return SharedSampleBuffer();
+    }
+
+    return AudioFileHandler::readAudioHeader( *stream, sampleHeader );
+}
+
+
+
+ProjectReader::Decoder* ProjectReader::takeNextDecoder()
+{
+    const ScopedLock lock( m_lock );
+
+    if ( m_isCancelled )
+    {
+        return nullptr;
+    }
+
+    int nextIndex = -1;
+    uint32 latestRequestTime = 0;
+
+    for ( int i = 0; i < m_pendingDecoders.size(); i++ )
+    {
+        const uint32 requestTime = m_pendingDecoders.getUnchecked( i )->getLoadRequestTime();
+
+        if ( nextIndex < 0 || requestTime > latestRequestTime )
+        {
+            nextIndex = i;
+            latestRequestTime = requestTime;
+        }
+    }
+
+    return nextIndex >= 0 ? m_pendingDecoders.removeAndReturn( nextIndex ) : nullptr;
+}
+
+
+
+void ProjectReader::finishDecoder( const bool isSuccessful )
+{
+    if ( ! isSuccessful )
+    {
+        ++m_numFailedDecoders;
+    }
+
+    --m_numDecodersLeft;
+}
@@ -0,0 +1,100 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef PROJECTREADER_H
+#define PROJECTREADER_H
+
+#include <QThreadPool>
+#include "JuceHeader.h"
+#include "samplebuffer.h"
+#include "textfilehandler.h"
+
+
+// Reads a project straight from its zip archive, without extracting it to disk first. The archive's directory is
+// parsed once and only the headers of the audio files are read up front, giving a silent placeholder for each slice
+// so the project can be used straight away. The audio is then decoded into the placeholders on several threads in
+// the background, starting with the slices that are being shown, and is given the peaks stored alongside it
+// whenever those still match
+
+class ProjectReader
+{
+public:
+    ProjectReader( QString zipFilePath, QString projectName );
+
+    // Abandons any audio files that haven't started being decoded yet, and waits for the rest
+    ~ProjectReader();
+
+    // Returns false if the archive has no project settings or they can't be parsed
+    bool readProjectSettings( TextFileHandler::ProjectSettings& settings );
+
+    // Create placeholders for the named audio files in "sampleBuffers", in the same order as the names, set
+    // "sampleHeader" to the header info of the first file, and start decoding the files in the background.
+    // Returns false, leaving "sampleBuffers" empty, if the header of any of them can't be read
+    bool readSampleBuffers( QStringList audioFileNames,
+                            QList<SharedSampleBuffer>& sampleBuffers,
+                            SharedSampleHeader& sampleHeader );
+
+    // Returns true once all of the audio files have been decoded, or have failed to decode
+    bool isFinished() const                         { return m_numDecodersLeft.get() == 0; }
+
+    // Wait until all of the audio files have been decoded. Returns false if any of them couldn't be,
+    // in which case their placeholders are left silent
+    bool waitForSampleBuffers();
+
+private:
+    class Decoder;
+    class Worker;
+
+    // Returns the index of the named entry in the project's directory, or -1 if it's missing
+    int getEntryIndex( const QString& fileName );
+
+    // Read the whole of an entry into memory. Returns false if the entry is missing or can't be decompressed.
+    // Safe to call from several threads at once, as every entry stream opens the archive file for itself
+    bool readEntry( int entryIndex, MemoryBlock& data );
+
+    // Returns a placeholder for an audio file entry, or a null pointer if the entry's header can't be read
+    SharedSampleBuffer readAudioHeader( int entryIndex, SharedSampleHeader& sampleHeader );
+
+    // Removes and returns the next decoder to run: the one whose placeholder was asked for most recently, or else
+    // the first in file order. Returns a null pointer once there are none left or decoding has been cancelled
+    Decoder* takeNextDecoder();
+
+    void finishDecoder( bool isSuccessful );
+
+    ZipFile m_zipFile;
+    const String m_entryDirName;
+
+    OwnedArray<Decoder> m_decoders;
+
+    CriticalSection m_lock;
+    Array<Decoder*> m_pendingDecoders;
+    bool m_isCancelled;
+
+    Atomic<int> m_numDecodersLeft;
+    Atomic<int> m_numFailedDecoders;
+
+    QThreadPool m_threadPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( ProjectReader )
+};
+
+
+#endif // PROJECTREADER_H
@@ -99,6 +99,7 @@ void RubberbandAudioSource::releaseResources()
         m_stretcher = NULL;
     }
 
+    m_source->setPlaybackLatency( 0 );
     m_source->releaseResources();
 }
 
@@ -197,6 +198,17 @@ void RubberbandAudioSource::processNextAudioBlock()
         info.startSample = 0;
         info.numSamples = qMin( m_inSampleBuffer.getNumFrames(), numRequired );
 
+        // The output still held by the stretcher, and its latency, will be heard before the audio about to be pulled
+        // from the sampler. Tell the sampler how many of its input frames that is, so its playback position is in sync
+        const qreal timeRatio = m_globalTimeRatio * m_noteTimeRatio;
+
+        if ( timeRatio > 0.0 )
+        {
+            const int numOutputFramesHeld = qMax( m_stretcher->available(), 0 ) + getLatency();
+
+            m_source->setPlaybackLatency( roundToInt( numOutputFramesHeld / timeRatio ) );
+        }
+
         m_source->getNextAudioBlock( info, m_midiBuffer );
 
         if ( m_midiBuffer.isEmpty() )
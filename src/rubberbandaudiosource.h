@@ -55,6 +55,9 @@ public:
     // Only has an effect when JACK Sync is enabled
     void setOriginalBPM( qreal bpm )                                { m_originalBPM = bpm; }
 
+    // No. of frames by which the output lags behind the input; only valid after prepareToPlay()
+    int getLatency() const                                          { return m_stretcher != NULL ? (int) m_stretcher->getLatency() : 0; }
+
     // For JUCE use only!
     void prepareToPlay( int samplesPerBlockExpected, double sampleRate ) override;
     void releaseResources() override;
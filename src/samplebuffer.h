@@ -24,41 +24,502 @@
 #define SAMPLEBUFFER_H
 
 #include <QSharedPointer>
+#include <QList>
 #include "JuceHeader.h"
+#include "peakpyramid.h"
 
 
+// A single non-destructive edit; gain ramps are defined over the whole length of the buffer
+
+struct SampleEdit
+{
+    enum EditType { GAIN, GAIN_RAMP, REVERSE };
+
+    SampleEdit( const EditType editType = GAIN, const float start = 1.0f, const float end = 1.0f ) :
+        type( editType ),
+        startGain( start ),
+        endGain( end )
+    {
+    }
+
+    EditType type;
+    float startGain;
+    float endGain;
+};
+
+
+
+// An ordered list of edits, applied first to last whenever the sample data is read
+
+class SampleEditChain
+{
+public:
+    void push( const SampleEdit& edit )             { m_edits.append( edit ); }
+    void pop()                                      { if ( ! m_edits.isEmpty() ) m_edits.removeLast(); }
+    void clear()                                    { m_edits.clear(); }
+
+    bool isEmpty() const                            { return m_edits.isEmpty(); }
+    int size() const                                { return m_edits.size(); }
+    const SampleEdit& at( const int i ) const       { return m_edits.at( i ); }
+
+    // Map a frame position in the edited output to the corresponding position in the unedited
+    // sample data; returns the gain that should be applied to the sample found at that position
+    inline float mapFramePos( qreal& framePos, const int numFrames ) const
+    {
+        float gain = 1.0f;
+
+        for ( int i = m_edits.size() - 1; i >= 0; i-- )
+        {
+            const SampleEdit& edit = m_edits.at( i );
+
+            switch ( edit.type )
+            {
+            case SampleEdit::GAIN:
+                gain *= edit.startGain;
+                break;
+            case SampleEdit::GAIN_RAMP:
+                gain *= edit.startGain + ( edit.endGain - edit.startGain ) * (float) ( framePos / numFrames );
+                break;
+            case SampleEdit::REVERSE:
+                framePos = ( numFrames - 1 ) - framePos;
+                break;
+            default:
+                break;
+            }
+        }
+
+        return gain;
+    }
+
+    // Returns the edits which, when applied to "numFrames" unedited frames starting at "sourceStartFrame",
+    // reproduce the edited output from "startFrame" to "startFrame + numFrames"
+    SampleEditChain getSubRangeEdits( const int startFrame, const int numFrames, const int totalNumFrames,
+                                      int& sourceStartFrame ) const
+    {
+        SampleEditChain subRangeEdits;
+        int lowestFrame = startFrame;
+
+        for ( int i = m_edits.size() - 1; i >= 0; i-- )
+        {
+            const SampleEdit& edit = m_edits.at( i );
+
+            switch ( edit.type )
+            {
+            case SampleEdit::GAIN_RAMP:
+            {
+                const float gainDelta = edit.endGain - edit.startGain;
+                const float startGain = edit.startGain + gainDelta * lowestFrame / totalNumFrames;
+                const float endGain = edit.startGain + gainDelta * ( lowestFrame + numFrames ) / totalNumFrames;
+
+                subRangeEdits.m_edits.prepend( SampleEdit( SampleEdit::GAIN_RAMP, startGain, endGain ) );
+                break;
+            }
+            case SampleEdit::REVERSE:
+                lowestFrame = totalNumFrames - lowestFrame - numFrames;
+                subRangeEdits.m_edits.prepend( edit );
+                break;
+            default:
+                subRangeEdits.m_edits.prepend( edit );
+                break;
+            }
+        }
+
+        sourceStartFrame = lowestFrame;
+
+        return subRangeEdits;
+    }
+
+private:
+    QList<SampleEdit> m_edits;
+};
+
+
+
+// A reference-counted block of sample data that one or more sample buffers can refer to.
+// Its size is fixed when it is created, so the sample data never moves while it is being shared
+
+class SampleStorage : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<SampleStorage> Ptr;
+
+    SampleStorage( const int numChannels, const int numFrames, const bool isLoaded = true ) :
+        m_data( numChannels, numFrames ),
+        m_isLoaded( isLoaded ? 1 : 0 ),
+        m_loadRequestTime( 0 )
+    {
+        // Sample data that is still to be loaded is silent until it arrives
+        if ( ! isLoaded )
+        {
+            m_data.clear();
+        }
+    }
+
+    ~SampleStorage()
+    {
+        discardPeaks();
+    }
+
+    float* const* getArrayOfWritePointers()         { return m_data.getArrayOfWritePointers(); }
+    int getNumChannels() const                      { return m_data.getNumChannels(); }
+    int getNumFrames() const                        { return m_data.getNumSamples(); }
+
+    // The sample data can be loaded on another thread after the storage has been created, e.g. while a project is
+    // being opened. Until setLoaded() is called the data must not be read and its peaks must not be built
+    bool isLoaded() const                           { return m_isLoaded.get() != 0; }
+    void setLoaded()                                { m_isLoaded = 1; }
+
+    // Records when the sample data was last wanted, so that data being shown can be loaded before the rest
+    void requestLoad()                              { m_loadRequestTime = Time::getMillisecondCounter(); }
+    uint32 getLoadRequestTime() const               { return m_loadRequestTime.get(); }
+
+    // The peak pyramid starts being built in the background the first time it is needed,
+    // and is then kept until the sample data is modified
+    const PeakPyramid& getPeaks()
+    {
+        if ( m_peaks == nullptr )
+        {
+            m_peaks = new PeakPyramid( m_data.getArrayOfReadPointers(), getNumChannels(), getNumFrames() );
+            m_peaks->startBuilding();
+        }
+
+        return *m_peaks;
+    }
+
+    void writePeaks( OutputStream& stream )
+    {
+        getPeaks();
+        m_peaks->writeToStream( stream );
+    }
+
+    // Use peaks that were previously written by writePeaks() rather than building them from the sample data
+    bool readPeaks( InputStream& stream )
+    {
+        const PeakPyramid::Ptr peaks = new PeakPyramid( m_data.getArrayOfReadPointers(), getNumChannels(), getNumFrames() );
+
+        if ( ! peaks->readFromStream( stream ) )
+        {
+            return false;
+        }
+
+        discardPeaks();
+        m_peaks = peaks;
+
+        return true;
+    }
+
+    void discardPeaks()
+    {
+        if ( m_peaks != nullptr )
+        {
+            m_peaks->cancel();
+            m_peaks = nullptr;
+        }
+    }
+
+private:
+    AudioSampleBuffer m_data;
+    PeakPyramid::Ptr m_peaks;
+    Atomic<int> m_isLoaded;
+    Atomic<uint32> m_loadRequestTime;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( SampleStorage )
+};
+
+
+
+// Sample buffers refer to a range of frames in a SampleStorage block rather than owning their sample data,
+// so splitting and joining buffers can be done by creating new views instead of copying samples
+
 class SampleBuffer : public AudioSampleBuffer
 {
 public:
     SampleBuffer() :
-            AudioSampleBuffer()
+            AudioSampleBuffer(),
+            m_storageStartFrame( 0 ),
+            m_isDirty( true )
     {
     }
 
     SampleBuffer( int numChannels, int numFrames ) :
-            AudioSampleBuffer( numChannels, numFrames )
+            AudioSampleBuffer(),
+            m_storageStartFrame( 0 ),
+            m_isDirty( true )
+    {
+        referToStorage( new SampleStorage( numChannels, numFrames ), 0, numChannels, numFrames );
+    }
+
+    // Create a silent buffer whose sample data will be written into it later, possibly on another thread,
+    // after which setLoaded() must be called
+    static SampleBuffer* createPlaceholder( const int numChannels, const int numFrames )
     {
+        SampleBuffer* const placeholder = new SampleBuffer();
+        placeholder->referToStorage( new SampleStorage( numChannels, numFrames, false ), 0, numChannels, numFrames );
+
+        return placeholder;
     }
 
     SampleBuffer( float* const* dataToReferTo, int numChannels, int numFrames ) :
-            AudioSampleBuffer( dataToReferTo, numChannels, numFrames )
+            AudioSampleBuffer( dataToReferTo, numChannels, numFrames ),
+            m_storageStartFrame( 0 ),
+            m_isDirty( true )
     {
     }
 
     SampleBuffer( float* const* dataToReferTo, int numChannels, int startFrame, int numFrames ) :
-            AudioSampleBuffer( dataToReferTo, numChannels, startFrame, numFrames )
+            AudioSampleBuffer( dataToReferTo, numChannels, startFrame, numFrames ),
+            m_storageStartFrame( 0 ),
+            m_isDirty( true )
+    {
+    }
+
+    // Create a view onto a range of another buffer's sample data without copying it. The range is relative
+    // to the start of "parent" and may extend beyond either end, as long as it stays within the shared storage.
+    // Otherwise the range is copied, and any part of it that lies outside "parent" is filled with silence
+    SampleBuffer( const SampleBuffer& parent, int startFrame, int numFrames ) :
+            AudioSampleBuffer(),
+            m_storageStartFrame( 0 ),
+            m_isDirty( true )
     {
+        jassert( numFrames >= 0 );
+
+        const int storageStartFrame = parent.m_storageStartFrame + startFrame;
+
+        if ( parent.m_storage != nullptr &&
+             storageStartFrame >= 0 &&
+             storageStartFrame + numFrames <= parent.m_storage->getNumFrames() )
+        {
+            referToStorage( parent.m_storage, storageStartFrame, parent.getNumChannels(), numFrames );
+        }
+        else
+        {
+            jassert( startFrame >= 0 && startFrame + numFrames <= parent.getNumFrames() );
+
+            referToStorage( new SampleStorage( parent.getNumChannels(), numFrames ), 0, parent.getNumChannels(), numFrames );
+            clear();
+
+            const int copyStartFrame = jlimit( 0, parent.getNumFrames(), startFrame );
+            const int copyEndFrame = jlimit( 0, parent.getNumFrames(), startFrame + numFrames );
+
+            if ( copyEndFrame > copyStartFrame )
+            {
+                for ( int chanNum = 0; chanNum < parent.getNumChannels(); chanNum++ )
+                {
+                    copyFrom( chanNum, copyStartFrame - startFrame, parent, chanNum, copyStartFrame, copyEndFrame - copyStartFrame );
+                }
+            }
+        }
     }
 
     SampleBuffer( const SampleBuffer& other ) :
-            AudioSampleBuffer( other )
+            AudioSampleBuffer(),
+            m_storageStartFrame( 0 ),
+            m_edits( other.m_edits ),
+            m_isDirty( true )
     {
+        referToStorage( new SampleStorage( other.getNumChannels(), other.getNumFrames() ), 0,
+                        other.getNumChannels(), other.getNumFrames() );
+
+        for ( int chanNum = 0; chanNum < other.getNumChannels(); chanNum++ )
+        {
+            copyFrom( chanNum, 0, other, chanNum, 0, other.getNumFrames() );
+        }
     }
 
     int getNumFrames() const
     {
         return getNumSamples();
     }
+
+    // Hides AudioSampleBuffer::setSize() so that resizing always moves this buffer into a new storage block,
+    // leaving the sample data seen by any other views untouched
+    void setSize( int numChannels, int numFrames,
+                  bool keepExistingContent = false, bool clearExtraSpace = false, bool /*avoidReallocating*/ = false )
+    {
+        if ( numChannels == getNumChannels() && numFrames == getNumFrames() )
+        {
+            return;
+        }
+
+        const SampleStorage::Ptr newStorage = new SampleStorage( numChannels, numFrames );
+        float* const* const newData = newStorage->getArrayOfWritePointers();
+
+        int numFramesKept = 0;
+
+        if ( keepExistingContent )
+        {
+            numFramesKept = jmin( numFrames, getNumFrames() );
+
+            for ( int chanNum = 0; chanNum < jmin( numChannels, getNumChannels() ); chanNum++ )
+            {
+                FloatVectorOperations::copy( newData[ chanNum ], getReadPointer( chanNum ), numFramesKept );
+            }
+        }
+
+        if ( clearExtraSpace )
+        {
+            for ( int chanNum = 0; chanNum < numChannels; chanNum++ )
+            {
+                const int startFrame = chanNum < getNumChannels() ? numFramesKept : 0;
+
+                FloatVectorOperations::clear( newData[ chanNum ] + startFrame, numFrames - startFrame );
+            }
+        }
+
+        referToStorage( newStorage, 0, numChannels, numFrames );
+        m_isDirty = true;
+    }
+
+    // Give this buffer a private copy of its sample data if the data is shared with any other buffer.
+    // This must be called before sample data that might be shared is modified in place
+    void detach()
+    {
+        m_isDirty = true;
+
+        if ( m_storage != nullptr && m_storage->getReferenceCount() == 1 )
+        {
+            m_storage->discardPeaks();
+        }
+        else if ( m_storage != nullptr )
+        {
+            const SampleStorage::Ptr newStorage = new SampleStorage( getNumChannels(), getNumFrames() );
+
+            for ( int chanNum = 0; chanNum < getNumChannels(); chanNum++ )
+            {
+                FloatVectorOperations::copy( newStorage->getArrayOfWritePointers()[ chanNum ],
+                                             getReadPointer( chanNum ),
+                                             getNumFrames() );
+            }
+
+            referToStorage( newStorage, 0, getNumChannels(), getNumFrames() );
+        }
+    }
+
+    // Returns true if "other" refers to the frames immediately following this buffer's frames in the same storage block
+    bool isFollowedBy( const SampleBuffer& other ) const
+    {
+        return m_storage != nullptr &&
+               m_storage == other.m_storage &&
+               m_storageStartFrame + getNumFrames() == other.m_storageStartFrame;
+    }
+
+    // Returns the lowest and highest unedited sample values in a range of frames, using the peak pyramid of the
+    // underlying storage so that long ranges don't need to be scanned sample by sample once it is ready
+    Range<float> findPeaks( const int chanNum, const int startFrame, const int numFrames ) const
+    {
+        if ( m_storage == nullptr )
+        {
+            return findMinMax( chanNum, startFrame, numFrames );
+        }
+
+        return m_storage->getPeaks().getMinMax( chanNum, m_storageStartFrame + startFrame, numFrames );
+    }
+
+    // Start building the peak pyramid of the underlying storage, if it isn't already built
+    void preparePeaks() const
+    {
+        if ( m_storage != nullptr && isLoaded() )
+        {
+            m_storage->getPeaks();
+        }
+    }
+
+    // Write the peaks of this buffer's frames, reusing those of the underlying storage if this buffer covers all of it
+    void writePeaks( OutputStream& stream ) const
+    {
+        if ( isWholeStorage() )
+        {
+            m_storage->writePeaks( stream );
+        }
+        else
+        {
+            PeakPyramid peaks( getArrayOfReadPointers(), getNumChannels(), getNumFrames() );
+            peaks.writeToStream( stream );
+        }
+    }
+
+    // Read peaks written by writePeaks(). Returns false if the peaks don't fit this buffer, or if this buffer
+    // doesn't cover all of its underlying storage
+    bool readPeaks( InputStream& stream )
+    {
+        return isWholeStorage() && m_storage->readPeaks( stream );
+    }
+
+    // Returns true if findPeaks() can return the peaks in this range of frames without scanning all of them
+    bool arePeaksReady( const int startFrame, const int numFrames ) const
+    {
+        return m_storage == nullptr ||
+               ( isLoaded() && m_storage->getPeaks().isReady( m_storageStartFrame + startFrame, numFrames ) );
+    }
+
+    // Returns false while the sample data of a placeholder is still to be loaded. Asking also moves the data
+    // ahead of any that hasn't been asked for, so this is called whenever the buffer is about to be shown
+    bool isLoaded() const
+    {
+        if ( m_storage == nullptr || m_storage->isLoaded() )
+        {
+            return true;
+        }
+
+        m_storage->requestLoad();
+
+        return false;
+    }
+
+    // Called once the sample data of a placeholder, and any stored peaks, have been written into it
+    void setLoaded()
+    {
+        if ( m_storage != nullptr )
+        {
+            m_storage->setLoaded();
+        }
+    }
+
+    // Returns when the sample data of a placeholder was last asked for by isLoaded(), or 0 if it never has been
+    uint32 getLoadRequestTime() const
+    {
+        return m_storage != nullptr ? m_storage->getLoadRequestTime() : 0;
+    }
+
+    // Non-destructive edits; the sample data itself is never modified by these
+    const SampleEditChain& getEdits() const         { return m_edits; }
+    void setEdits( const SampleEditChain& edits )   { m_edits = edits; m_isDirty = true; }
+    void pushEdit( const SampleEdit& edit )         { m_edits.push( edit ); m_isDirty = true; }
+    void popEdit()                                  { m_edits.pop(); m_isDirty = true; }
+    bool hasEdits() const                           { return ! m_edits.isEmpty(); }
+
+    // A buffer is dirty from when it is created, or its sample data or edits are changed, until it is saved
+    // or loaded and marked clean; clean buffers don't need to be written again when the project is saved
+    bool isDirty() const                            { return m_isDirty; }
+    void setClean()                                 { m_isDirty = false; }
+
+private:
+    bool isWholeStorage() const
+    {
+        return m_storage != nullptr && m_storageStartFrame == 0 && getNumFrames() == m_storage->getNumFrames();
+    }
+
+    void referToStorage( const SampleStorage::Ptr storage, const int startFrame, const int numChannels, const int numFrames )
+    {
+        HeapBlock<float*> channels( numChannels );
+
+        for ( int chanNum = 0; chanNum < numChannels; chanNum++ )
+        {
+            channels[ chanNum ] = storage->getArrayOfWritePointers()[ chanNum ] + startFrame;
+        }
+
+        setDataToReferTo( channels, numChannels, numFrames );
+
+        m_storage = storage;
+        m_storageStartFrame = startFrame;
+    }
+
+    SampleStorage::Ptr m_storage;
+    int m_storageStartFrame;
+    SampleEditChain m_edits;
+    bool m_isDirty;
+
+    SampleBuffer& operator=( const SampleBuffer& );
 };
 
 typedef QSharedPointer<SampleBuffer> SharedSampleBuffer;
@@ -0,0 +1,195 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "samplekernels.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+
+// Only mono and stereo are specialised; other channel counts use the generic loops below
+template <> void SampleKernels::interleave<1>( const float* const* input, int numFrames, float* output );
+template <> void SampleKernels::interleave<2>( const float* const* input, int numFrames, float* output );
+template <> void SampleKernels::deinterleave<1>( const float* input, int numFrames, float* const* output );
+template <> void SampleKernels::deinterleave<2>( const float* input, int numFrames, float* const* output );
+
+
+//==================================================================================================
+// Public Static:
+
+void SampleKernels::interleave( const float* const* const input, const int numChans, const int numFrames, float* const output )
+{
+    switch ( numChans )
+    {
+    case 1:
+        interleave<1>( input, numFrames, output );
+        break;
+    case 2:
+        interleave<2>( input, numFrames, output );
+        break;
+    default:
+        for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+        {
+            for ( int frameNum = 0; frameNum < numFrames; ++frameNum )
+            {
+                output[ numChans * frameNum + chanNum ] = input[ chanNum ][ frameNum ];
+            }
+        }
+        break;
+    }
+}
+
+
+
+void SampleKernels::deinterleave( const float* const input, const int numChans, const int numFrames, float* const* const output )
+{
+    switch ( numChans )
+    {
+    case 1:
+        deinterleave<1>( input, numFrames, output );
+        break;
+    case 2:
+        deinterleave<2>( input, numFrames, output );
+        break;
+    default:
+        for ( int chanNum = 0; chanNum < numChans; ++chanNum )
+        {
+            for ( int frameNum = 0; frameNum < numFrames; ++frameNum )
+            {
+                output[ chanNum ][ frameNum ] = input[ numChans * frameNum + chanNum ];
+            }
+        }
+        break;
+    }
+}
+
+
+
+void SampleKernels::floatToPcmClipped( const float* const input, const int numSamples, const int bitsPerSample, int* const output )
+{
+    jassert( bitsPerSample > 0 && bitsPerSample < 32 );
+
+    // Both limits are exactly representable as floats for bit depths of up to 24
+    const float scale = (float) ( 1 << ( bitsPerSample - 1 ) );
+    const float maxValue = scale - 1.0f;
+    const int shift = 32 - bitsPerSample;
+
+    int i = 0;
+
+  #if JUCE_INTEL
+    const __m128 scaleVector = _mm_set1_ps( scale );
+    const __m128 minVector = _mm_set1_ps( -scale );
+    const __m128 maxVector = _mm_set1_ps( maxValue );
+
+    for ( ; i + 4 <= numSamples; i += 4 )
+    {
+        const __m128 scaled = _mm_mul_ps( _mm_loadu_ps( input + i ), scaleVector );
+        const __m128 clipped = _mm_min_ps( _mm_max_ps( scaled, minVector ), maxVector );
+
+        // Rounds to nearest, as lrintf() does
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( output + i ),
+                          _mm_sll_epi32( _mm_cvtps_epi32( clipped ), _mm_cvtsi32_si128( shift ) ) );
+    }
+  #endif
+
+    for ( ; i < numSamples; ++i )
+    {
+        const float clipped = jlimit( -scale, maxValue, input[ i ] * scale );
+
+        output[ i ] = (int) ( (uint32) lrintf( clipped ) << shift );
+    }
+}
+
+
+
+//==================================================================================================
+// Private Static:
+
+template <>
+void SampleKernels::interleave<1>( const float* const* const input, const int numFrames, float* const output )
+{
+    memcpy( output, input[ 0 ], (size_t) numFrames * sizeof( float ) );
+}
+
+
+
+template <>
+void SampleKernels::interleave<2>( const float* const* const input, const int numFrames, float* const output )
+{
+    const float* const left = input[ 0 ];
+    const float* const right = input[ 1 ];
+
+    int frameNum = 0;
+
+  #if JUCE_INTEL
+    for ( ; frameNum + 4 <= numFrames; frameNum += 4 )
+    {
+        const __m128 l = _mm_loadu_ps( left + frameNum );
+        const __m128 r = _mm_loadu_ps( right + frameNum );
+
+        _mm_storeu_ps( output + 2 * frameNum,     _mm_unpacklo_ps( l, r ) );
+        _mm_storeu_ps( output + 2 * frameNum + 4, _mm_unpackhi_ps( l, r ) );
+    }
+  #endif
+
+    for ( ; frameNum < numFrames; ++frameNum )
+    {
+        output[ 2 * frameNum ]     = left[ frameNum ];
+        output[ 2 * frameNum + 1 ] = right[ frameNum ];
+    }
+}
+
+
+
+template <>
+void SampleKernels::deinterleave<1>( const float* const input, const int numFrames, float* const* const output )
+{
+    memcpy( output[ 0 ], input, (size_t) numFrames * sizeof( float ) );
+}
+
+
+
+template <>
+void SampleKernels::deinterleave<2>( const float* const input, const int numFrames, float* const* const output )
+{
+    float* const left = output[ 0 ];
+    float* const right = output[ 1 ];
+
+    int frameNum = 0;
+
+  #if JUCE_INTEL
+    for ( ; frameNum + 4 <= numFrames; frameNum += 4 )
+    {
+        const __m128 a = _mm_loadu_ps( input + 2 * frameNum );
+        const __m128 b = _mm_loadu_ps( input + 2 * frameNum + 4 );
+
+        _mm_storeu_ps( left + frameNum,  _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+        _mm_storeu_ps( right + frameNum, _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+    }
+  #endif
+
+    for ( ; frameNum < numFrames; ++frameNum )
+    {
+        left[ frameNum ]  = input[ 2 * frameNum ];
+        right[ frameNum ] = input[ 2 * frameNum + 1 ];
+    }
+}
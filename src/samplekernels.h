@@ -0,0 +1,52 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef SAMPLEKERNELS_H
+#define SAMPLEKERNELS_H
+
+#include "JuceHeader.h"
+
+
+// The inner loops of reading and writing audio files: conversion between the separate channels of a
+// SampleBuffer and the interleaved frames of a file, and from floats to PCM. Mono and stereo, the only
+// channel counts Shuriken supports, are specialised at compile time and use SSE2 on Intel
+
+class SampleKernels
+{
+public:
+    // Interleave "numFrames" frames of the "numChans" channels in "input" into "output"
+    static void interleave( const float* const* input, int numChans, int numFrames, float* output );
+
+    // Split "numFrames" interleaved frames of "numChans" channels in "input" into the channels of "output"
+    static void deinterleave( const float* input, int numChans, int numFrames, float* const* output );
+
+    // Round "numSamples" floats to "bitsPerSample"-bit PCM, clipping anything beyond full scale, and shift the
+    // result to the top of a 32-bit int. Rounding happens at the target bit depth, so truncating the ints back
+    // down to "bitsPerSample" bits, as libsndfile does when writing ints to a narrower format, loses nothing
+    static void floatToPcmClipped( const float* input, int numSamples, int bitsPerSample, int* output );
+
+private:
+    template <int numChans> static void interleave( const float* const* input, int numFrames, float* output );
+    template <int numChans> static void deinterleave( const float* input, int numFrames, float* const* output );
+};
+
+
+#endif // SAMPLEKERNELS_H
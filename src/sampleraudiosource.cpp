@@ -41,6 +41,9 @@ SamplerAudioSource::SamplerAudioSource( const bool isMonophonic, AudioIODevice*
     m_isLoopingEnabled( false ),
     m_noteCounter( 0 ),
     m_frameCounter( 0 ),
+    m_seqFrameCounter( 0 ),
+    m_playbackLatency( 0 ),
+    m_playbackFrameNum( -1 ),
     m_jackDevice( audioDevice != NULL && audioDevice->canHandleMidiInput() ? audioDevice : NULL )
 {
 }
@@ -96,6 +99,7 @@ void SamplerAudioSource::playSample( const int sampleNum, const SharedSampleRang
     m_noteCounter = 0;
     m_noteCounterEnd = 1;
     m_frameCounter = 0;
+    m_playbackFrameNum = 0;
     m_isPlaying = true;
 }
 
@@ -111,6 +115,7 @@ void SamplerAudioSource::playAll()
     m_noteCounter = 0;
     m_noteCounterEnd = m_sampleBufferList.size();
     m_frameCounter = 0;
+    m_playbackFrameNum = 0;
     m_isPlaying = true;
 }
 
@@ -122,6 +127,7 @@ void SamplerAudioSource::stop()
     const bool allowTailOff = false;
 
     m_isPlaying = false;
+    m_playbackFrameNum = -1;
     m_sampler.allNotesOff( midiChannel, allowTailOff );
     m_tempSampleRange.clear();
 }
@@ -336,6 +342,7 @@ void SamplerAudioSource::getNextAudioBlock( const AudioSourceChannelInfo& info,
                 else
                 {
                     m_isPlaying = false;  // End of sequence reached
+                    m_playbackFrameNum = -1;
                     m_tempSampleRange.clear();
                 }
             }
@@ -353,6 +360,12 @@ void SamplerAudioSource::getNextAudioBlock( const AudioSourceChannelInfo& info,
 
                 midiBuffer.addEvent( message, noteOnFrameNum );
 
+                // Start of sequence or loop
+                if ( m_noteCounter == 0 )
+                {
+                    m_seqFrameCounter = -noteOnFrameNum;
+                }
+
                 int numFrames = 0;
 
                 if ( ! m_tempSampleRange.isNull() )
@@ -378,6 +391,17 @@ void SamplerAudioSource::getNextAudioBlock( const AudioSourceChannelInfo& info,
             {
                 m_frameCounter -= info.numSamples;
             }
+
+            // Publish how far through the sequence playback has got. This is done here, in the same
+            // block as the note-on above, so a sequence started by the GUI thread between the checks
+            // of m_isPlaying never publishes a stale frame count
+            if ( m_playbackSampleRate > 0.0 )
+            {
+                const int heardFrameNum = qMax( m_seqFrameCounter - m_playbackLatency, 0 );
+
+                m_playbackFrameNum = roundToInt( heardFrameNum * ( m_fileSampleRate / m_playbackSampleRate ) );
+                m_seqFrameCounter += info.numSamples;
+            }
         }
     }
 
@@ -43,6 +43,17 @@ public:
     void stop();
     void setLooping( bool isLoopingDesired );
 
+    // Returns the no. of frames played so far by 'playSample()' or 'playAll()', at the sample rate of the samples
+    // being played, or -1 if nothing is playing. This is published by the audio thread, so the GUI can use it to
+    // keep the playhead in sync with what is actually being heard
+    int getPlaybackFrameNum() const                 { return m_playbackFrameNum.get(); }
+
+    // Set by a source that pulls audio from this one ahead of the output, such as RubberbandAudioSource, to the
+    // no. of frames at the playback sample rate by which what is heard lags behind what is being pulled.
+    // This is subtracted from the published playback position. Should only be called from the audio thread, or
+    // while the audio device is stopped
+    void setPlaybackLatency( int numFrames )        { m_playbackLatency = numFrames; }
+
     qreal getAttack( int sampleNum ) const;
     void setAttack( int sampleNum, qreal value );   // Value should be 0.00 - 1.00
 
@@ -106,6 +117,12 @@ private:
     volatile int m_noteCounterEnd;
     volatile int m_frameCounter;
 
+    // Frames played so far at the playback sample rate. Only ever read or written by the audio thread,
+    // which resets it on the first note-on of each sequence or loop
+    int m_seqFrameCounter;
+    volatile int m_playbackLatency;
+    Atomic<int> m_playbackFrameNum;
+
     AudioIODevice* const m_jackDevice;
 
 private:
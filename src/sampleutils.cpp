@@ -21,8 +21,13 @@
 */
 
 #include "sampleutils.h"
+#include "zerocrossingindex.h"
 #include <QtDebug>
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 
 SharedSampleBuffer SampleUtils::joinSampleBuffers( const QList<SharedSampleBuffer> sampleBufferList )
 {
@@ -37,6 +42,21 @@ SharedSampleBuffer SampleUtils::joinSampleBuffers( const QList<SharedSampleBuffe
         totalNumFrames += sampleBuffer->getNumFrames();
     }
 
+    // If the buffers are unedited views onto consecutive ranges of the same storage then the
+    // joined buffer is simply a view onto the whole range and no sample data needs to be copied
+    bool isContiguous = ! sampleBufferList.first()->hasEdits();
+
+    for ( int i = 1; i < sampleBufferList.size() && isContiguous; i++ )
+    {
+        isContiguous = ! sampleBufferList.at( i )->hasEdits() &&
+                       sampleBufferList.at( i - 1 )->isFollowedBy( *sampleBufferList.at( i ).data() );
+    }
+
+    if ( isContiguous )
+    {
+        return SharedSampleBuffer( new SampleBuffer( *sampleBufferList.first().data(), 0, totalNumFrames ) );
+    }
+
     SharedSampleBuffer newSampleBuffer( new SampleBuffer( numChans, totalNumFrames ) );
 
     int startFrame = 0;
@@ -45,9 +65,12 @@ SharedSampleBuffer SampleUtils::joinSampleBuffers( const QList<SharedSampleBuffe
     {
         const int numFrames = sampleBuffer->getNumFrames();
 
+        // Edited slices can't be joined as a view, so their edits are rendered into the joined copy
+        const SharedSampleBuffer sourceBuffer = renderEdits( sampleBuffer );
+
         for ( int chanNum = 0; chanNum < numChans; chanNum++ )
         {
-            newSampleBuffer->copyFrom( chanNum, startFrame, *sampleBuffer.data(), chanNum, 0, numFrames );
+            newSampleBuffer->copyFrom( chanNum, startFrame, *sourceBuffer.data(), chanNum, 0, numFrames );
         }
 
         startFrame += numFrames;
@@ -74,7 +97,7 @@ QList<SharedSampleBuffer> SampleUtils::splitSampleBuffer( const SharedSampleBuff
         slicePointFrameNums << totalNumFrames;
     }
 
-    const int numChans = sampleBuffer->getNumChannels();
+    const SampleEditChain& edits = sampleBuffer->getEdits();
 
     int startFrame = 0;
 
@@ -86,14 +109,15 @@ QList<SharedSampleBuffer> SampleUtils::splitSampleBuffer( const SharedSampleBuff
 
             if ( numFrames > 0 )
             {
-                SharedSampleBuffer newSampleBuffer( new SampleBuffer( numChans, numFrames ) );
+                // Each slice is a view onto the original buffer's storage, so no sample data is copied.
+                // Any non-destructive edits are carried over by mapping them onto the slice's range
+                int sourceStartFrame = 0;
+                const SampleEditChain sliceEdits = edits.getSubRangeEdits( startFrame, numFrames, totalNumFrames, sourceStartFrame );
 
-                for ( int chanNum = 0; chanNum < numChans; chanNum++ )
-                {
-                    newSampleBuffer->copyFrom( chanNum, 0, *sampleBuffer.data(), chanNum, startFrame, numFrames );
-                }
+                SharedSampleBuffer slice( new SampleBuffer( *sampleBuffer.data(), sourceStartFrame, numFrames ) );
+                slice->setEdits( sliceEdits );
 
-                sampleBufferList << newSampleBuffer;
+                sampleBufferList << slice;
 
                 startFrame += numFrames;
             }
@@ -119,7 +143,105 @@ int SampleUtils::getTotalNumFrames( const QList<SharedSampleBuffer> sampleBuffer
 
 
 
-int SampleUtils::getPrevZeroCrossing( const SharedSampleBuffer sampleBuffer, const int startFrameNum )
+SharedSampleBuffer SampleUtils::createSharedCopy( const SharedSampleBuffer sampleBuffer )
+{
+    SharedSampleBuffer sharedCopy( new SampleBuffer( *sampleBuffer.data(), 0, sampleBuffer->getNumFrames() ) );
+    sharedCopy->setEdits( sampleBuffer->getEdits() );
+
+    return sharedCopy;
+}
+
+
+
+SharedSampleBuffer SampleUtils::renderEdits( const SharedSampleBuffer sampleBuffer )
+{
+    if ( ! sampleBuffer->hasEdits() )
+    {
+        return sampleBuffer;
+    }
+
+    const SampleEditChain edits = sampleBuffer->getEdits();
+    const int numFrames = sampleBuffer->getNumFrames();
+
+    SharedSampleBuffer renderedSampleBuffer( new SampleBuffer( *sampleBuffer.data() ) );
+    renderedSampleBuffer->setEdits( SampleEditChain() );
+
+    for ( int i = 0; i < edits.size(); i++ )
+    {
+        const SampleEdit& edit = edits.at( i );
+
+        switch ( edit.type )
+        {
+        case SampleEdit::GAIN:
+            renderedSampleBuffer->applyGain( 0, numFrames, edit.startGain );
+            break;
+        case SampleEdit::GAIN_RAMP:
+            renderedSampleBuffer->applyGainRamp( 0, numFrames, edit.startGain, edit.endGain );
+            break;
+        case SampleEdit::REVERSE:
+            renderedSampleBuffer->reverse( 0, numFrames );
+            break;
+        default:
+            break;
+        }
+    }
+
+    return renderedSampleBuffer;
+}
+
+
+
+SharedSampleBuffer SampleUtils::renderEdits( const SharedSampleBuffer sampleBuffer, const int startFrame, const int numFrames )
+{
+    // A view onto just the unedited frames that the range maps to, with the edits mapped onto it
+    int sourceStartFrame = 0;
+    const SampleEditChain rangeEdits = sampleBuffer->getEdits().getSubRangeEdits( startFrame, numFrames,
+                                                                                 sampleBuffer->getNumFrames(),
+                                                                                 sourceStartFrame );
+
+    SharedSampleBuffer range( new SampleBuffer( *sampleBuffer.data(), sourceStartFrame, numFrames ) );
+    range->setEdits( rangeEdits );
+
+    return renderEdits( range );
+}
+
+
+
+float SampleUtils::getEditedMagnitude( const SharedSampleBuffer sampleBuffer )
+{
+    const int numFrames = sampleBuffer->getNumFrames();
+
+    if ( ! sampleBuffer->hasEdits() )
+    {
+        return sampleBuffer->getMagnitude( 0, numFrames );
+    }
+
+    const SampleEditChain& edits = sampleBuffer->getEdits();
+    const int numChans = sampleBuffer->getNumChannels();
+
+    float magnitude = 0.0f;
+
+    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
+    {
+        const float* const sampleData = sampleBuffer->getReadPointer( chanNum );
+
+        for ( int frameNum = 0; frameNum < numFrames; frameNum++ )
+        {
+            qreal framePos = frameNum;
+            const float gain = edits.mapFramePos( framePos, numFrames );
+
+            magnitude = qMax( magnitude, std::abs( sampleData[ (int) framePos ] * gain ) );
+        }
+    }
+
+    return magnitude;
+}
+
+
+
+int SampleUtils::getPrevZeroCrossing( const SharedSampleBuffer sampleBuffer,
+                                      const int startFrameNum,
+                                      const ZeroCrossingIndex* const index )
 {
     int zeroCrossingFrameNum = 0;
 
@@ -131,26 +253,23 @@ int SampleUtils::getPrevZeroCrossing( const SharedSampleBuffer sampleBuffer, con
 
         for ( int chanNum = 0; chanNum < numChans; ++chanNum )
         {
+            const float* const sampleData = sampleBuffer->getReadPointer( chanNum );
+
             int frameNum = startFrameNum;
 
-            // If the value of the start sample is positive then find the previous negative sample
-            if ( sampleBuffer->getSample( chanNum, startFrameNum ) > 0.0f )
+            // If the value of the start sample is positive then find the previous negative sample, and vice versa
+            if ( sampleData[ startFrameNum ] != 0.0f )
             {
-                while ( frameNum > 0 && sampleBuffer->getSample( chanNum, frameNum ) > 0.0f )
-                    --frameNum;
-            }
-            // If the value of the start sample is negative then find the previous positive sample
-            else if ( sampleBuffer->getSample( chanNum, startFrameNum ) < 0.0f )
-            {
-                while ( frameNum > 0 && sampleBuffer->getSample( chanNum, frameNum ) < 0.0f )
-                    --frameNum;
+                const int runStartFrameNum = ( index != NULL ) ? index->getStartOfRun( chanNum, startFrameNum ) :
+                                                                 findStartOfRun( sampleData, startFrameNum );
+                frameNum = qMax( runStartFrameNum - 1, 0 );
             }
 
             // Determine the smallest of the two sample values at the zero-crossing
             if ( frameNum + 1 < numFrames )
             {
-                const float leftAbsSampleValue = qAbs( sampleBuffer->getSample(chanNum, frameNum) );
-                const float rightAbsSampleValue = qAbs( sampleBuffer->getSample(chanNum, frameNum + 1) );
+                const float leftAbsSampleValue = qAbs( sampleData[ frameNum ] );
+                const float rightAbsSampleValue = qAbs( sampleData[ frameNum + 1 ] );
 
                 if ( rightAbsSampleValue < leftAbsSampleValue )
                     ++frameNum;
@@ -169,7 +288,9 @@ int SampleUtils::getPrevZeroCrossing( const SharedSampleBuffer sampleBuffer, con
 
 
 
-int SampleUtils::getNextZeroCrossing( const SharedSampleBuffer sampleBuffer, const int startFrameNum )
+int SampleUtils::getNextZeroCrossing( const SharedSampleBuffer sampleBuffer,
+                                      const int startFrameNum,
+                                      const ZeroCrossingIndex* const index )
 {
     int zeroCrossingFrameNum = sampleBuffer->getNumFrames() - 1;
 
@@ -181,26 +302,23 @@ int SampleUtils::getNextZeroCrossing( const SharedSampleBuffer sampleBuffer, con
 
         for ( int chanNum = 0; chanNum < numChans; ++chanNum )
         {
+            const float* const sampleData = sampleBuffer->getReadPointer( chanNum );
+
             int frameNum = startFrameNum;
 
-            // If the value of the start sample is positive then find the next negative sample
-            if ( sampleBuffer->getSample( chanNum, startFrameNum ) > 0.0f )
-            {
-                while ( frameNum < numFrames - 1 && sampleBuffer->getSample( chanNum, frameNum ) > 0.0f )
-                    ++frameNum;
-            }
-            // If the value of the start sample is negative then find the next positive sample
-            else if ( sampleBuffer->getSample( chanNum, startFrameNum ) < 0.0f )
+            // If the value of the start sample is positive then find the next negative sample, and vice versa
+            if ( sampleData[ startFrameNum ] != 0.0f )
             {
-                while ( frameNum < numFrames - 1 && sampleBuffer->getSample( chanNum, frameNum ) < 0.0f )
-                    ++frameNum;
+                const int runEndFrameNum = ( index != NULL ) ? index->getEndOfRun( chanNum, startFrameNum ) :
+                                                               findEndOfRun( sampleData, numFrames, startFrameNum );
+                frameNum = qMin( runEndFrameNum, numFrames - 1 );
             }
 
             // Determine the smallest of the two sample values at the zero-crossing
             if ( frameNum - 1 >= 0 )
             {
-                const float leftAbsSampleValue = qAbs( sampleBuffer->getSample(chanNum, frameNum - 1) );
-                const float rightAbsSampleValue = qAbs( sampleBuffer->getSample(chanNum, frameNum) );
+                const float leftAbsSampleValue = qAbs( sampleData[ frameNum - 1 ] );
+                const float rightAbsSampleValue = qAbs( sampleData[ frameNum ] );
 
                 if ( leftAbsSampleValue < rightAbsSampleValue )
                     --frameNum;
@@ -219,10 +337,12 @@ int SampleUtils::getNextZeroCrossing( const SharedSampleBuffer sampleBuffer, con
 
 
 
-int SampleUtils::getClosestZeroCrossing( const SharedSampleBuffer sampleBuffer, const int startFrameNum )
+int SampleUtils::getClosestZeroCrossing( const SharedSampleBuffer sampleBuffer,
+                                         const int startFrameNum,
+                                         const ZeroCrossingIndex* const index )
 {
-    const int prevZeroCrossing = getPrevZeroCrossing( sampleBuffer, startFrameNum );
-    const int nextZeroCrossing = getNextZeroCrossing( sampleBuffer, startFrameNum );
+    const int prevZeroCrossing = getPrevZeroCrossing( sampleBuffer, startFrameNum, index );
+    const int nextZeroCrossing = getNextZeroCrossing( sampleBuffer, startFrameNum, index );
 
     if ( startFrameNum - prevZeroCrossing < nextZeroCrossing - startFrameNum )
     {
@@ -233,3 +353,69 @@ int SampleUtils::getClosestZeroCrossing( const SharedSampleBuffer sampleBuffer,
         return nextZeroCrossing;
     }
 }
+
+
+
+int SampleUtils::findStartOfRun( const float* const sampleData, const int frameNum )
+{
+    const float value = sampleData[ frameNum ];
+
+    int runStartFrameNum = frameNum;
+
+#ifdef __SSE__
+    // Check four samples at a time, working backwards, until a block is found that isn't entirely
+    // on the same side of zero (or entirely zero) as the sample at "frameNum"
+    const __m128 zero = _mm_setzero_ps();
+
+    while ( runStartFrameNum >= 4 )
+    {
+        const __m128 samples = _mm_loadu_ps( sampleData + runStartFrameNum - 4 );
+        const __m128 isSameSide = value > 0.0f ? _mm_cmpgt_ps( samples, zero ) :
+                                  value < 0.0f ? _mm_cmplt_ps( samples, zero ) :
+                                                 _mm_cmpeq_ps( samples, zero );
+
+        if ( _mm_movemask_ps( isSameSide ) != 0xF )
+            break;
+
+        runStartFrameNum -= 4;
+    }
+#endif
+
+    while ( runStartFrameNum > 0 && getSign( sampleData[ runStartFrameNum - 1 ] ) == getSign( value ) )
+        --runStartFrameNum;
+
+    return runStartFrameNum;
+}
+
+
+
+int SampleUtils::findEndOfRun( const float* const sampleData, const int numFrames, const int frameNum )
+{
+    const float value = sampleData[ frameNum ];
+
+    int runEndFrameNum = frameNum + 1;
+
+#ifdef __SSE__
+    // Check four samples at a time until a block is found that isn't entirely
+    // on the same side of zero (or entirely zero) as the sample at "frameNum"
+    const __m128 zero = _mm_setzero_ps();
+
+    while ( runEndFrameNum + 4 <= numFrames )
+    {
+        const __m128 samples = _mm_loadu_ps( sampleData + runEndFrameNum );
+        const __m128 isSameSide = value > 0.0f ? _mm_cmpgt_ps( samples, zero ) :
+                                  value < 0.0f ? _mm_cmplt_ps( samples, zero ) :
+                                                 _mm_cmpeq_ps( samples, zero );
+
+        if ( _mm_movemask_ps( isSameSide ) != 0xF )
+            break;
+
+        runEndFrameNum += 4;
+    }
+#endif
+
+    while ( runEndFrameNum < numFrames && getSign( sampleData[ runEndFrameNum ] ) == getSign( value ) )
+        ++runEndFrameNum;
+
+    return runEndFrameNum;
+}
@@ -25,23 +25,54 @@
 
 #include "samplebuffer.h"
 
+class ZeroCrossingIndex;
+
 
 class SampleUtils
 {
 public:
+    // Join sample buffers into one. Unedited views onto consecutive frames of the same storage are
+    // joined without copying; otherwise a new buffer is created with any edits rendered into it
     static SharedSampleBuffer joinSampleBuffers( QList<SharedSampleBuffer> sampleBufferList );
 
     // Split a sample buffer into multiple sample buffers at the specified slice points.
-    // Slice points greater than or equal to the length of the sample buffer are ignored
+    // Slice points greater than or equal to the length of the sample buffer are ignored.
+    // The slices are views onto the original sample data and inherit its edits, so nothing is copied
     static QList<SharedSampleBuffer> splitSampleBuffer( SharedSampleBuffer sampleBuffer, QList<int> slicePointFrameNums );
 
     static int getTotalNumFrames( QList<SharedSampleBuffer> sampleBufferList );
 
-    static int getPrevZeroCrossing( SharedSampleBuffer sampleBuffer, int startFrameNum );
+    // Returns a new sample buffer that shares the original's sample data and has its own copy of the original's edits.
+    // The sample data is only copied if either buffer is later modified in place
+    static SharedSampleBuffer createSharedCopy( SharedSampleBuffer sampleBuffer );
+
+    // Returns a sample buffer with any non-destructive edits rendered into its sample data.
+    // If there are no edits then the original sample buffer is returned and nothing is copied
+    static SharedSampleBuffer renderEdits( SharedSampleBuffer sampleBuffer );
+
+    // As above, but only the "numFrames" edited frames starting at "startFrame" are rendered
+    static SharedSampleBuffer renderEdits( SharedSampleBuffer sampleBuffer, int startFrame, int numFrames );
+
+    // Returns the highest absolute sample value found after any non-destructive edits have been applied
+    static float getEditedMagnitude( SharedSampleBuffer sampleBuffer );
+
+    // Find the zero-crossing nearest to the start frame. If a zero-crossing index for the sample buffer
+    // is given then it is used to look up sign changes instead of scanning the sample data
+    static int getPrevZeroCrossing( SharedSampleBuffer sampleBuffer, int startFrameNum, const ZeroCrossingIndex* index = NULL );
+
+    static int getNextZeroCrossing( SharedSampleBuffer sampleBuffer, int startFrameNum, const ZeroCrossingIndex* index = NULL );
+
+    static int getClosestZeroCrossing( SharedSampleBuffer sampleBuffer, int startFrameNum, const ZeroCrossingIndex* index = NULL );
+
+    // A "run" is a sequence of samples that are all positive, all negative or all zero.
+    // Returns the first frame of the run containing "frameNum"
+    static int findStartOfRun( const float* sampleData, int frameNum );
 
-    static int getNextZeroCrossing( SharedSampleBuffer sampleBuffer, int startFrameNum );
+    // Returns the frame after the last frame of the run containing "frameNum"
+    static int findEndOfRun( const float* sampleData, int numFrames, int frameNum );
 
-    static int getClosestZeroCrossing( SharedSampleBuffer sampleBuffer, int startFrameNum );
+private:
+    static inline int getSign( const float value )  { return ( value > 0.0f ) - ( value < 0.0f ); }
 };
 
 
@@ -57,6 +57,7 @@ ShurikenSamplerSound::ShurikenSamplerSound( const SharedSampleBuffer sampleBuffe
                                             const BigInteger& notes,
                                             const int midiNoteForNormalPitch ) :
     m_sampleBuffer( sampleBuffer ),
+    m_edits( sampleBuffer->getEdits() ),
     m_originalStartFrame( 0 ),
     m_originalEndFrame( sampleBuffer->getNumFrames() - 1 ),
     m_sourceSampleRate( sampleRate ),
@@ -291,10 +292,26 @@ void ShurikenSamplerVoice::renderNextBlock( AudioSampleBuffer& outputBuffer, int
 
         const int totalnumFrames = playingSound->m_sampleBuffer->getNumFrames();
 
+        const SampleEditChain& edits = playingSound->m_edits;
+        const bool hasEdits = ! edits.isEmpty();
+
         while ( --numFrames >= 0 )
         {
-            const int pos = (int) m_sourceSamplePosition;
-            const float alpha = (float) ( m_sourceSamplePosition - pos );
+            qreal readPosition = m_sourceSamplePosition;
+            float editGain = 1.0f;
+
+            if ( hasEdits )
+            {
+                editGain = edits.mapFramePos( readPosition, totalnumFrames );
+
+                if ( readPosition < 0.0 )
+                {
+                    readPosition = 0.0;
+                }
+            }
+
+            const int pos = (int) readPosition;
+            const float alpha = (float) ( readPosition - pos );
             const float invAlpha = 1.0f - alpha;
 
             float l = 0;
@@ -312,8 +329,8 @@ void ShurikenSamplerVoice::renderNextBlock( AudioSampleBuffer& outputBuffer, int
                 r = ( inR != nullptr ) ? ( inR[ pos ] * invAlpha ) : l;
             }
 
-            l *= m_leftGain;
-            r *= m_rightGain;
+            l *= m_leftGain * editGain;
+            r *= m_rightGain * editGain;
 
             if ( m_isInAttack )
             {
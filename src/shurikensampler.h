@@ -91,6 +91,7 @@ private:
     friend class ShurikenSamplerVoice;
 
     const SharedSampleBuffer m_sampleBuffer;
+    const SampleEditChain m_edits; // Snapshot of the sample buffer's edits, applied at render time
     const int m_originalStartFrame, m_originalEndFrame;
     const qreal m_sourceSampleRate;
     BigInteger m_midiNotes;
@@ -0,0 +1,245 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "sliceexporter.h"
+#include "sampleutils.h"
+#include <QRunnable>
+
+
+//==================================================================================================
+// Saves a single slice, or encodes it into memory if there is no directory to save it in
+
+class SliceExporter::Job : public QRunnable
+{
+public:
+    Job( SliceExporter& exporter,
+         const SharedSampleBuffer sampleBuffer,
+         const QString dirPath,
+         const QString fileBaseName,
+         const int currentSampleRate,
+         const int outputSampleRate,
+         const int sndFileFormat,
+         const SliceRenderer::Settings& renderSettings ) :
+        m_exporter( exporter ),
+        m_sampleBuffer( sampleBuffer ),
+        m_dirPath( dirPath ),
+        m_fileBaseName( fileBaseName ),
+        m_currentSampleRate( currentSampleRate ),
+        m_outputSampleRate( outputSampleRate ),
+        m_sndFileFormat( sndFileFormat ),
+        m_renderSettings( renderSettings )
+    {
+        setAutoDelete( false );
+    }
+
+    void run()
+    {
+        if ( ! m_exporter.isCancelled() )
+        {
+            m_sampleBuffer = SampleUtils::renderEdits( m_sampleBuffer );
+            m_sampleBuffer = SliceRenderer::render( m_sampleBuffer, m_currentSampleRate, m_renderSettings );
+
+            if ( m_dirPath.isEmpty() )
+            {
+                const bool isSuccessful = m_exporter.m_fileHandler.encodeAudioData( m_sampleBuffer,
+                                                                                    m_currentSampleRate,
+                                                                                    m_outputSampleRate,
+                                                                                    m_sndFileFormat,
+                                                                                    m_encodedData );
+                if ( isSuccessful )
+                {
+                    m_filePath = m_fileBaseName + AudioFileHandler::getFileExtension( m_sndFileFormat );
+                }
+            }
+            else
+            {
+                m_filePath = m_exporter.m_fileHandler.saveAudioFile( m_dirPath,
+                                                                     m_fileBaseName,
+                                                                     m_sampleBuffer,
+                                                                     m_currentSampleRate,
+                                                                     m_outputSampleRate,
+                                                                     m_sndFileFormat );
+            }
+
+            // The last error is recorded per thread, so it has to be fetched here
+            if ( m_filePath.isEmpty() )
+            {
+                m_errorTitle = m_exporter.m_fileHandler.getLastErrorTitle();
+                m_errorInfo = m_exporter.m_fileHandler.getLastErrorInfo();
+            }
+        }
+
+        ++m_exporter.m_numSlicesDone;
+    }
+
+    QString getFilePath() const                 { return m_filePath; }
+    const MemoryBlock& getEncodedData() const   { return m_encodedData; }
+    SharedSampleBuffer getSampleBuffer() const  { return m_sampleBuffer; }
+    QString getErrorTitle() const               { return m_errorTitle; }
+    QString getErrorInfo() const                { return m_errorInfo; }
+
+private:
+    SliceExporter& m_exporter;
+
+    SharedSampleBuffer m_sampleBuffer;
+    const QString m_dirPath;
+    const QString m_fileBaseName;
+    const int m_currentSampleRate;
+    const int m_outputSampleRate;
+    const int m_sndFileFormat;
+    const SliceRenderer::Settings m_renderSettings;
+
+    QString m_filePath;
+    MemoryBlock m_encodedData;
+    QString m_errorTitle;
+    QString m_errorInfo;
+};
+
+
+
+//==================================================================================================
+// Public:
+
+SliceExporter::SliceExporter( AudioFileHandler& fileHandler ) :
+    m_fileHandler( fileHandler )
+{
+}
+
+
+
+SliceExporter::~SliceExporter()
+{
+    cancel();
+    m_threadPool.waitForDone();
+}
+
+
+
+void SliceExporter::addSlice( const SharedSampleBuffer sampleBuffer,
+                              const QString dirPath,
+                              const QString fileBaseName,
+                              const int currentSampleRate,
+                              const int outputSampleRate,
+                              const int sndFileFormat,
+                              const SliceRenderer::Settings& renderSettings )
+{
+    Job* const job = m_jobs.add( new Job( *this,
+                                          sampleBuffer,
+                                          dirPath,
+                                          fileBaseName,
+                                          currentSampleRate,
+                                          outputSampleRate,
+                                          sndFileFormat,
+                                          renderSettings ) );
+    m_threadPool.start( job );
+}
+
+
+
+void SliceExporter::addSlice( const SharedSampleBuffer sampleBuffer,
+                              const QString fileBaseName,
+                              const int currentSampleRate,
+                              const int outputSampleRate,
+                              const int sndFileFormat,
+                              const SliceRenderer::Settings& renderSettings )
+{
+    addSlice( sampleBuffer, QString(), fileBaseName, currentSampleRate, outputSampleRate, sndFileFormat, renderSettings );
+}
+
+
+
+bool SliceExporter::waitForDone( const int msecs )
+{
+    return m_threadPool.waitForDone( msecs );
+}
+
+
+
+QStringList SliceExporter::getFilePaths() const
+{
+    QStringList filePaths;
+
+    for ( int i = 0; i < m_jobs.size(); i++ )
+    {
+        filePaths << m_jobs[ i ]->getFilePath();
+    }
+
+    return filePaths;
+}
+
+
+
+const MemoryBlock& SliceExporter::getEncodedData( const int sliceNum ) const
+{
+    return m_jobs[ sliceNum ]->getEncodedData();
+}
+
+
+
+SharedSampleBuffer SliceExporter::getSampleBuffer( const int sliceNum ) const
+{
+    return m_jobs[ sliceNum ]->getSampleBuffer();
+}
+
+
+
+bool SliceExporter::wasSuccessful() const
+{
+    for ( int i = 0; i < m_jobs.size(); i++ )
+    {
+        if ( m_jobs[ i ]->getFilePath().isEmpty() )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+QString SliceExporter::getErrorTitle() const
+{
+    for ( int i = 0; i < m_jobs.size(); i++ )
+    {
+        if ( ! m_jobs[ i ]->getErrorTitle().isEmpty() )
+        {
+            return m_jobs[ i ]->getErrorTitle();
+        }
+    }
+
+    return QString();
+}
+
+
+
+QString SliceExporter::getErrorInfo() const
+{
+    for ( int i = 0; i < m_jobs.size(); i++ )
+    {
+        if ( ! m_jobs[ i ]->getErrorTitle().isEmpty() )
+        {
+            return m_jobs[ i ]->getErrorInfo();
+        }
+    }
+
+    return QString();
+}
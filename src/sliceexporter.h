@@ -0,0 +1,107 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef SLICEEXPORTER_H
+#define SLICEEXPORTER_H
+
+#include "JuceHeader.h"
+#include "audiofilehandler.h"
+#include "slicerenderer.h"
+#include <QThreadPool>
+#include <QStringList>
+
+
+// Saves slices as audio files on a pool of worker threads. Each slice is resampled, if need be, and encoded
+// independently of the others, so the GUI thread is left free to show progress and to cancel the export
+
+class SliceExporter
+{
+public:
+    // "fileHandler" is not owned by the exporter and must outlive it
+    SliceExporter( AudioFileHandler& fileHandler );
+
+    // Cancels any slices that haven't been started and waits for the rest
+    ~SliceExporter();
+
+    // Queue "sampleBuffer" to be saved in "dirPath"; the arguments are as for AudioFileHandler::saveAudioFile().
+    // Slices are started in the order they're added. On the worker thread, the slice's edits are first rendered
+    // and it is then run through SliceRenderer, which does nothing with the default settings
+    void addSlice( SharedSampleBuffer sampleBuffer,
+                   QString dirPath,
+                   QString fileBaseName,
+                   int currentSampleRate,
+                   int outputSampleRate,
+                   int sndFileFormat,
+                   const SliceRenderer::Settings& renderSettings = SliceRenderer::Settings() );
+
+    // As above, but the slice is encoded into memory rather than saved, for writing into an archive.
+    // The encoded data is given by getEncodedData()
+    void addSlice( SharedSampleBuffer sampleBuffer,
+                   QString fileBaseName,
+                   int currentSampleRate,
+                   int outputSampleRate,
+                   int sndFileFormat,
+                   const SliceRenderer::Settings& renderSettings = SliceRenderer::Settings() );
+
+    // Wait up to "msecs" milliseconds for every slice to be saved, failed or skipped. Returns true once they all have
+    bool waitForDone( int msecs );
+
+    // Skip the slices that haven't been started yet. Slices that are being saved are finished
+    void cancel()                               { m_isCancelled.set( 1 ); }
+    bool isCancelled() const                    { return m_isCancelled.get() != 0; }
+
+    int getNumSlices() const                    { return m_jobs.size(); }
+    int getNumSlicesDone() const                { return m_numSlicesDone.get(); }
+
+    // Only valid once waitForDone() has returned true. The paths of the saved files in the order the slices were
+    // added; the path is empty for any slice that failed or was skipped. Slices encoded into memory just have a file name
+    QStringList getFilePaths() const;
+
+    // Only valid once waitForDone() has returned true
+    const MemoryBlock& getEncodedData( int sliceNum ) const;
+
+    // Only valid once waitForDone() has returned true. The sample data that was exported, after rendering
+    SharedSampleBuffer getSampleBuffer( int sliceNum ) const;
+
+    // Only valid once waitForDone() has returned true. Returns false if any slice failed or was skipped,
+    // in which case the error of the first slice that failed is given
+    bool wasSuccessful() const;
+    QString getErrorTitle() const;
+    QString getErrorInfo() const;
+
+private:
+    class Job;
+
+    AudioFileHandler& m_fileHandler;
+
+    Atomic<int> m_isCancelled;
+    Atomic<int> m_numSlicesDone;
+
+    OwnedArray<Job> m_jobs;
+
+    // Declared last so that it's destroyed first, waiting for any jobs that are running
+    QThreadPool m_threadPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( SliceExporter )
+};
+
+
+#endif // SLICEEXPORTER_H
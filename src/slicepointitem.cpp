@@ -120,10 +120,41 @@ void SlicePointItem::moveToNextZeroCrossing()
     WaveGraphicsScene* const waveScene = static_cast<WaveGraphicsScene*>( scene() );
 
     const SharedSampleBuffer sampleBuffer = waveScene->getWaveformAt( 0 )->getSampleBuffer();
+    const int totalNumFrames = sampleBuffer->getNumFrames();
+
+    // There are no zero-crossings to find until the sample data has been loaded
+    if ( ! sampleBuffer->isLoaded() )
+    {
+        return;
+    }
 
     const int oldFrameNum = getFrameNum();
 
-    const int newFrameNum = SampleUtils::getNextZeroCrossing( sampleBuffer, oldFrameNum + 1 );
+    // The search starts from the frame after the slice point, but also needs the slice point's own frame
+    const int searchStartFrame = qMin( oldFrameNum, totalNumFrames );
+    int searchSize = ZERO_CROSSING_SEARCH_SIZE;
+    int newFrameNum = totalNumFrames - 1;
+
+    while ( true )
+    {
+        const int searchEndFrame = qMin( oldFrameNum + 1 + searchSize, totalNumFrames );
+
+        const SharedSampleBuffer searchBuffer = SampleUtils::renderEdits( sampleBuffer,
+                                                                          searchStartFrame,
+                                                                          searchEndFrame - searchStartFrame );
+
+        newFrameNum = searchStartFrame + SampleUtils::getNextZeroCrossing( searchBuffer, oldFrameNum + 1 - searchStartFrame );
+
+        // A run that reaches the end of the rendered frames is reported at, or one before, the last frame;
+        // the zero-crossing may then lie beyond them
+        if ( newFrameNum < searchEndFrame - 2 || searchEndFrame == totalNumFrames )
+        {
+            break;
+        }
+
+        searchSize *= 2;
+    }
+
     setFrameNum( newFrameNum );
 
     const qreal newScenePosX = waveScene->getScenePosX( newFrameNum );
@@ -139,10 +170,41 @@ void SlicePointItem::moveToPrevZeroCrossing()
     WaveGraphicsScene* const waveScene = static_cast<WaveGraphicsScene*>( scene() );
 
     const SharedSampleBuffer sampleBuffer = waveScene->getWaveformAt( 0 )->getSampleBuffer();
+    const int totalNumFrames = sampleBuffer->getNumFrames();
+
+    // There are no zero-crossings to find until the sample data has been loaded
+    if ( ! sampleBuffer->isLoaded() )
+    {
+        return;
+    }
 
     const int oldFrameNum = getFrameNum();
 
-    const int newFrameNum = SampleUtils::getPrevZeroCrossing( sampleBuffer, oldFrameNum - 1 );
+    // The search starts from the frame before the slice point, but also needs the slice point's own frame
+    const int searchEndFrame = qMin( oldFrameNum + 1, totalNumFrames );
+    int searchSize = ZERO_CROSSING_SEARCH_SIZE;
+    int newFrameNum = 0;
+
+    while ( true )
+    {
+        const int searchStartFrame = qMax( oldFrameNum - 1 - searchSize, 0 );
+
+        const SharedSampleBuffer searchBuffer = SampleUtils::renderEdits( sampleBuffer,
+                                                                          searchStartFrame,
+                                                                          searchEndFrame - searchStartFrame );
+
+        newFrameNum = searchStartFrame + SampleUtils::getPrevZeroCrossing( searchBuffer, oldFrameNum - 1 - searchStartFrame );
+
+        // A run that reaches the start of the rendered frames is reported at, or one after, the first frame;
+        // the zero-crossing may then lie before them
+        if ( newFrameNum > searchStartFrame + 1 || searchStartFrame == 0 )
+        {
+            break;
+        }
+
+        searchSize *= 2;
+    }
+
     setFrameNum( newFrameNum );
 
     const qreal newScenePosX = waveScene->getScenePosX( newFrameNum );
@@ -178,7 +240,15 @@ QVariant SlicePointItem::itemChange( GraphicsItemChange change, const QVariant&
         // Snap slice point to BPM ruler marks
         if ( m_isSnapEnabled )
         {
-            foreach ( SharedGraphicsItem item, waveScene->getBpmRulerMarks() )
+            const SharedGraphicsItem item = waveScene->getNearestBpmRulerMark( newPos.x() );
+
+            if ( ! m_snappedRulerMark.isNull() && m_snappedRulerMark != item )
+            {
+                setRulerMarkColour( m_snappedRulerMark.data(), Qt::white );
+                m_snappedRulerMark.clear();
+            }
+
+            if ( ! item.isNull() )
             {
                 const qreal itemPosX = item->scenePos().x();
 
@@ -187,10 +257,12 @@ QVariant SlicePointItem::itemChange( GraphicsItemChange change, const QVariant&
                     newPos.setX( itemPosX );
 
                     setRulerMarkColour( item.data(), Qt::lightGray );
+                    m_snappedRulerMark = item;
                 }
-                else
+                else if ( m_snappedRulerMark == item )
                 {
                     setRulerMarkColour( item.data(), Qt::white );
+                    m_snappedRulerMark.clear();
                 }
             }
         }
@@ -294,10 +366,11 @@ void SlicePointItem::mouseReleaseEvent( QGraphicsSceneMouseEvent* event )
             emit scenePosChanged( this, oldFrameNum );
         }
 
-        // Reset colour of BPM ruler marks
-        foreach ( SharedGraphicsItem item, scene->getBpmRulerMarks() )
+        // Reset colour of BPM ruler mark
+        if ( ! m_snappedRulerMark.isNull() )
         {
-            setRulerMarkColour( item.data(), Qt::white );
+            setRulerMarkColour( m_snappedRulerMark.data(), Qt::white );
+            m_snappedRulerMark.clear();
         }
 
         m_isLeftMousePressed = false;
@@ -352,27 +425,35 @@ void SlicePointItem::contextMenuEvent( QGraphicsSceneContextMenuEvent* event )
 
 void SlicePointItem::calcMinMaxScenePosX()
 {
+    const WaveGraphicsScene* const waveScene = static_cast<WaveGraphicsScene*>( scene() );
+
     qreal minX = scene()->sceneRect().left();
     qreal maxX = scene()->sceneRect().right() - 1;
 
-    foreach ( QGraphicsItem* item, scene()->items() )
+    // Slice points are kept in frame order by the scene so only the nearest neighbours need to be checked,
+    // skipping any that share this slice point's position
+    SharedSlicePointItem prevSlicePoint = waveScene->getPrevSlicePoint( this );
+
+    while ( ! prevSlicePoint.isNull() && prevSlicePoint->scenePos().x() >= pos().x() )
     {
-        if ( item != this && item->type() == SlicePointItem::Type )
-        {
-            SlicePointItem* const otherSlicePoint = qgraphicsitem_cast<SlicePointItem*>( item );
+        prevSlicePoint = waveScene->getPrevSlicePoint( prevSlicePoint.data() );
+    }
 
-            const qreal otherItemPosX = otherSlicePoint->scenePos().x();
+    if ( ! prevSlicePoint.isNull() && prevSlicePoint->scenePos().x() > minX )
+    {
+        minX = prevSlicePoint->scenePos().x();
+    }
 
-            if ( otherItemPosX > minX && otherItemPosX < pos().x() )
-            {
-                minX = otherItemPosX;
-            }
+    SharedSlicePointItem nextSlicePoint = waveScene->getNextSlicePoint( this );
 
-            if ( otherItemPosX < maxX && otherItemPosX > pos().x() )
-            {
-                maxX = otherItemPosX;
-            }
-        }
+    while ( ! nextSlicePoint.isNull() && nextSlicePoint->scenePos().x() <= pos().x() )
+    {
+        nextSlicePoint = waveScene->getNextSlicePoint( nextSlicePoint.data() );
+    }
+
+    if ( ! nextSlicePoint.isNull() && nextSlicePoint->scenePos().x() < maxX )
+    {
+        maxX = nextSlicePoint->scenePos().x();
     }
 
     m_minScenePosX = minX + m_minDistFromOtherItems;
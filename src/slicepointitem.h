@@ -79,6 +79,10 @@ private:
     // Calculate how far this slice point can be moved to the left and the right
     void calcMinMaxScenePosX();
 
+    // No. of frames rendered around the slice point when first searching for a zero-crossing;
+    // doubled until one is found, so that edits never have to be rendered for the whole waveform
+    static const int ZERO_CROSSING_SEARCH_SIZE = 4096;
+
     const QBrush m_selectedBrush;
     const bool m_canBeMovedPastOtherSlicePoints;
 
@@ -92,6 +96,9 @@ private:
     qreal m_minScenePosX;
     qreal m_maxScenePosX;
 
+    // The BPM ruler mark this slice point is currently snapped to, if any
+    QSharedPointer<QGraphicsItem> m_snappedRulerMark;
+
 private:
     static void setRulerMarkColour( QGraphicsItem* item, QColor colour );
 
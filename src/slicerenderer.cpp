@@ -0,0 +1,66 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "slicerenderer.h"
+#include "offlinetimestretcher.h"
+
+
+//==================================================================================================
+// Public Static:
+
+SharedSampleBuffer SliceRenderer::render( const SharedSampleBuffer sampleBuffer, const int sampleRate, const Settings& settings )
+{
+    const int numChans = sampleBuffer->getNumChannels();
+    const int numFrames = sampleBuffer->getNumFrames();
+
+    // Same length as the sampler's attack when a slice is played at its original pitch
+    const int numAttackFrames = static_cast<int>( settings.attackValue * numFrames );
+
+    const bool isStretched = settings.timeRatio != 1.0 || settings.pitchScale != 1.0;
+
+    if ( numAttackFrames <= 0 && ! isStretched )
+    {
+        return sampleBuffer;
+    }
+
+    const SharedSampleBuffer renderedBuffer( new SampleBuffer( *sampleBuffer.data() ) );
+
+    if ( numAttackFrames > 0 )
+    {
+        for ( int chanNum = 0; chanNum < numChans; chanNum++ )
+        {
+            renderedBuffer->applyGainRamp( chanNum, 0, jmin( numAttackFrames, numFrames ), 0.0f, 1.0f );
+        }
+    }
+
+    // The stretcher follows the sampler during playback, so the attack is stretched too
+    if ( isStretched )
+    {
+        OfflineTimeStretcher::stretch( renderedBuffer,
+                                       sampleRate,
+                                       numChans,
+                                       settings.stretcherOptions & ~RubberBandStretcher::OptionProcessRealTime,
+                                       settings.timeRatio,
+                                       settings.pitchScale );
+    }
+
+    return renderedBuffer;
+}
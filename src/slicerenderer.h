@@ -0,0 +1,60 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef SLICERENDERER_H
+#define SLICERENDERER_H
+
+#include "samplebuffer.h"
+#include <rubberband/RubberBandStretcher.h>
+
+using namespace RubberBand;
+
+
+// Renders a slice offline the way it sounds when it's played: the attack envelope applied by the sampler,
+// then the time stretch applied in real-time mode. Edits should already have been rendered. The release
+// envelope isn't rendered as it only starts when a note is released, so it's left to the exported metadata
+
+class SliceRenderer
+{
+public:
+    struct Settings
+    {
+        Settings() :
+            timeRatio( 1.0 ),
+            pitchScale( 1.0 ),
+            stretcherOptions( RubberBandStretcher::DefaultOptions ),
+            attackValue( 0.0 )
+        {
+        }
+
+        qreal timeRatio;                                // Global time ratio multiplied by the slice's note time ratio
+        qreal pitchScale;
+        RubberBandStretcher::Options stretcherOptions;
+        qreal attackValue;                              // Value in the range 0.00 - 1.00
+    };
+
+    // Returns a new sample buffer, or "sampleBuffer" itself if there is nothing to render.
+    // "sampleBuffer" is never modified, so this can be called from any thread
+    static SharedSampleBuffer render( SharedSampleBuffer sampleBuffer, int sampleRate, const Settings& settings );
+};
+
+
+#endif // SLICERENDERER_H
@@ -0,0 +1,212 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "targzwriter.h"
+
+
+//==================================================================================================
+// Public:
+
+TarGzWriter::TarGzWriter( const File& tarGzFile ) :
+    m_tempFile( tarGzFile ),
+    m_output( new FileOutputStream( m_tempFile.getFile() ) ),
+    m_modTime( Time::currentTimeMillis() / 1000 ),
+    m_isOk( true )
+{
+    if ( m_output->failedToOpen() )
+    {
+        m_output = nullptr;
+        m_isOk = false;
+    }
+    else
+    {
+        m_compressor = new GZIPCompressorOutputStream( m_output, 9, false, GZIPCompressorOutputStream::windowBitsGZIP );
+    }
+}
+
+
+
+TarGzWriter::~TarGzWriter()
+{
+    // The compressor writes any remaining data to the output stream when it's deleted
+    m_compressor = nullptr;
+    m_output = nullptr;
+}
+
+
+
+bool TarGzWriter::addDirectory( const String& dirName )
+{
+    jassert( m_output != nullptr );
+
+    return writeHeader( dirName + "/", '5', 0755, 0 );
+}
+
+
+
+bool TarGzWriter::addFile( const String& fileName, const void* const data, const size_t numBytes )
+{
+    jassert( m_output != nullptr );
+
+    return writeHeader( fileName, '0', 0644, (int64) numBytes ) && writeData( data, numBytes );
+}
+
+
+
+bool TarGzWriter::finish()
+{
+    if ( m_output == nullptr )
+    {
+        return false;
+    }
+
+    // The end of the archive is marked by two blocks of zeros
+    const char zeros[ BLOCK_SIZE * 2 ] = { 0 };
+
+    if ( ! m_compressor->write( zeros, sizeof( zeros ) ) )
+    {
+        m_isOk = false;
+    }
+
+    m_compressor = nullptr;
+    m_output->flush();
+
+    if ( m_output->getStatus().failed() )
+    {
+        m_isOk = false;
+    }
+
+    m_output = nullptr;
+
+    return m_isOk && m_tempFile.overwriteTargetFileWithTemporary();
+}
+
+
+
+//==================================================================================================
+// Private:
+
+bool TarGzWriter::writeHeader( const String& name, const char typeFlag, const int mode, const int64 size )
+{
+    const char* const nameData = name.toRawUTF8();
+    const int nameSize = (int) name.getNumBytesAsUTF8();
+
+    if ( nameSize <= NAME_FIELD_SIZE )
+    {
+        return writeHeader( nameData, nameSize, nullptr, 0, typeFlag, mode, size );
+    }
+
+    // Try to split the name at a slash, putting the start of it in the prefix field
+    for ( int i = jmax( 1, nameSize - NAME_FIELD_SIZE - 1 ); i <= PREFIX_FIELD_SIZE && i < nameSize - 1; ++i )
+    {
+        if ( nameData[ i ] == '/' )
+        {
+            return writeHeader( nameData + i + 1, nameSize - i - 1, nameData, i, typeFlag, mode, size );
+        }
+    }
+
+    // Too long for ustar, so precede the header with a GNU long name entry, which is understood by GNU tar
+    // and libarchive. The entry's data is the full name, including its terminating null
+    return writeHeader( "././@LongLink", 13, nullptr, 0, 'L', 0644, nameSize + 1 ) &&
+           writeData( nameData, (size_t) nameSize + 1 ) &&
+           writeHeader( nameData, NAME_FIELD_SIZE, nullptr, 0, typeFlag, mode, size );
+}
+
+
+
+bool TarGzWriter::writeHeader( const char* const name,
+                               const int nameSize,
+                               const char* const prefix,
+                               const int prefixSize,
+                               const char typeFlag,
+                               const int mode,
+                               const int64 size )
+{
+    jassert( nameSize <= NAME_FIELD_SIZE && prefixSize <= PREFIX_FIELD_SIZE );
+
+    char header[ BLOCK_SIZE ] = { 0 };
+
+    memcpy( header, name, (size_t) nameSize );
+    writeOctal( header + 100, 8, mode );
+    writeOctal( header + 108, 8, 0 );               // User ID
+    writeOctal( header + 116, 8, 0 );               // Group ID
+    writeOctal( header + 124, 12, size );
+    writeOctal( header + 136, 12, m_modTime );
+    header[ 156 ] = typeFlag;
+    memcpy( header + 257, "ustar", 6 );
+    memcpy( header + 263, "00", 2 );
+
+    if ( prefixSize > 0 )
+    {
+        memcpy( header + 345, prefix, (size_t) prefixSize );
+    }
+
+    // The checksum is calculated with the checksum field filled with spaces
+    memset( header + 148, ' ', 8 );
+
+    int checksum = 0;
+
+    for ( int i = 0; i < BLOCK_SIZE; i++ )
+    {
+        checksum += (uint8) header[ i ];
+    }
+
+    writeOctal( header + 148, 7, checksum );
+
+    if ( ! m_compressor->write( header, BLOCK_SIZE ) )
+    {
+        m_isOk = false;
+    }
+
+    return m_isOk;
+}
+
+
+
+bool TarGzWriter::writeData( const void* const data, const size_t numBytes )
+{
+    const char zeros[ BLOCK_SIZE ] = { 0 };
+    const size_t paddingSize = ( BLOCK_SIZE - numBytes % BLOCK_SIZE ) % BLOCK_SIZE;
+
+    if ( ! m_compressor->write( data, numBytes ) || ! m_compressor->write( zeros, paddingSize ) )
+    {
+        m_isOk = false;
+    }
+
+    return m_isOk;
+}
+
+
+
+//==================================================================================================
+// Private Static:
+
+void TarGzWriter::writeOctal( char* const field, const int fieldSize, int64 value )
+{
+    // Zero-padded octal digits followed by a null
+    field[ fieldSize - 1 ] = 0;
+
+    for ( int i = fieldSize - 2; i >= 0; --i )
+    {
+        field[ i ] = (char) ( '0' + ( value & 7 ) );
+        value >>= 3;
+    }
+}
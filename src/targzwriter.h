@@ -0,0 +1,74 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef TARGZWRITER_H
+#define TARGZWRITER_H
+
+#include "JuceHeader.h"
+
+
+// Writes a gzipped tar archive, such as a Hydrogen drumkit, in a single pass. Each entry is written straight
+// through the compressor, so nothing has to be staged on disk. Like ZipWriter, the archive is written to a temp
+// file next to the destination file, which is only replaced once finish() has written the whole archive
+
+class TarGzWriter
+{
+public:
+    TarGzWriter( const File& tarGzFile );
+    ~TarGzWriter();
+
+    bool failedToOpen() const                       { return m_output == nullptr; }
+
+    // Add a directory entry. "dirName" shouldn't end with a slash
+    bool addDirectory( const String& dirName );
+
+    // Add a file entry holding "numBytes" bytes of "data"
+    bool addFile( const String& fileName, const void* data, size_t numBytes );
+
+    // Write the end of the archive and move it into place. Returns false if anything went wrong
+    // while writing the archive, in which case the destination file is left untouched
+    bool finish();
+
+private:
+    // Write a header, preceded by a GNU long name entry if "name" won't fit in the ustar name fields
+    bool writeHeader( const String& name, char typeFlag, int mode, int64 size );
+
+    bool writeHeader( const char* name, int nameSize, const char* prefix, int prefixSize, char typeFlag, int mode, int64 size );
+
+    // Write the data of an entry, padded with zeros to a whole no. of blocks
+    bool writeData( const void* data, size_t numBytes );
+
+    static void writeOctal( char* field, int fieldSize, int64 value );
+
+    TemporaryFile m_tempFile;
+    ScopedPointer<FileOutputStream> m_output;
+    ScopedPointer<GZIPCompressorOutputStream> m_compressor;
+    const int64 m_modTime;
+    bool m_isOk;
+
+    static const int BLOCK_SIZE = 512;
+    static const int NAME_FIELD_SIZE = 100;
+    static const int PREFIX_FIELD_SIZE = 155;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( TarGzWriter )
+};
+
+#endif // TARGZWRITER_H
@@ -29,7 +29,7 @@
 //==================================================================================================
 // Public Static:
 
-bool TextFileHandler::createProjectXmlFile( const QString filePath, const ProjectSettings& settings )
+void TextFileHandler::writeProjectXml( OutputStream& stream, const ProjectSettings& settings )
 {
     XmlElement docElement( "project" );
     docElement.setAttribute( "name", settings.projectName.toLocal8Bit().data() );
@@ -115,17 +115,15 @@ bool TextFileHandler::createProjectXmlFile( const QString filePath, const Projec
     monophonyElement->setAttribute( "checked", settings.isMonophonyEnabled );
     docElement.addChildElement( monophonyElement );
 
-    File file( filePath.toLocal8Bit().data() );
-
-    return docElement.writeToFile( file, String::empty );
+    docElement.writeToStream( stream, String::empty );
 }
 
 
 
-bool TextFileHandler::readProjectXmlFile( const QString filePath, ProjectSettings& settings )
+bool TextFileHandler::readProjectXml( InputStream& stream, ProjectSettings& settings )
 {
     ScopedPointer<XmlElement> docElement;
-    docElement = XmlDocument::parse( File( filePath.toLocal8Bit().data() ) );
+    docElement = XmlDocument::parse( stream.readEntireStreamAsString() );
 
     bool isSuccessful = false;
 
@@ -247,6 +245,13 @@ bool TextFileHandler::createPathsConfigFile( const PathsConfig& config )
         docElement.addChildElement( element );
     }
 
+    if ( config.projectStorage >= 0 )
+    {
+        XmlElement* element = new XmlElement( "project_storage" );
+        element->setAttribute( "mode", config.projectStorage );
+        docElement.addChildElement( element );
+    }
+
     foreach ( QString path, config.recentProjectPaths )
     {
         XmlElement* element = new XmlElement( "recent_project" );
@@ -283,6 +288,10 @@ bool TextFileHandler::readPathsConfigFile( PathsConfig& config )
                 {
                     config.recentProjectPaths << elem->getStringAttribute( "path" ).toRawUTF8();
                 }
+                else if ( elem->hasTagName( "project_storage" ) )
+                {
+                    config.projectStorage = elem->getIntAttribute( "mode", -1 );
+                }
             }
 
             isSuccessful = true;
@@ -294,9 +303,10 @@ bool TextFileHandler::readPathsConfigFile( PathsConfig& config )
 
 
 
-bool TextFileHandler::createH2DrumkitXmlFile( const QString dirPath, const QString kitName,
-                                              const QStringList audioFileNames,
-                                              const SamplerAudioSource::EnvelopeSettings& envelopes )
+void TextFileHandler::writeH2DrumkitXml( OutputStream& stream,
+                                         const QString kitName,
+                                         const QStringList audioFileNames,
+                                         const SamplerAudioSource::EnvelopeSettings& envelopes )
 {
     Q_ASSERT( audioFileNames.size() == envelopes.attackValues.size() );
 
@@ -307,7 +317,7 @@ bool TextFileHandler::createH2DrumkitXmlFile( const QString dirPath, const QStri
     docElement.setAttribute( "xmlns", "http://www.hydrogen-music.org/drumkit" );
 
     XmlElement* nameElement = new XmlElement( "name" );
-    nameElement->addTextElement( kitName.toLocal8Bit().data() );
+    nameElement->addTextElement( String::fromUTF8( kitName.toUtf8().constData() ) );
     docElement.addChildElement( nameElement );
 
     XmlElement* authorElement = new XmlElement( "author" );
@@ -333,7 +343,7 @@ bool TextFileHandler::createH2DrumkitXmlFile( const QString dirPath, const QStri
         instrumentElement->addChildElement( idElement );
 
         XmlElement* nameElement = new XmlElement( "name" );
-        String name( kitName.toLocal8Bit().data() );
+        String name = String::fromUTF8( kitName.toUtf8().constData() );
         name += " ";
         name += String( i + 1 );
         nameElement->addTextElement( name );
@@ -429,7 +439,7 @@ bool TextFileHandler::createH2DrumkitXmlFile( const QString dirPath, const QStri
 
         {
             XmlElement* filenameElement = new XmlElement( "filename" );
-            filenameElement->addTextElement( audioFileNames.at( i ).toLocal8Bit().data() );
+            filenameElement->addTextElement( String::fromUTF8( audioFileNames.at( i ).toUtf8().constData() ) );
             layerElement->addChildElement( filenameElement );
 
             XmlElement* minElement = new XmlElement( "min" );
@@ -456,9 +466,7 @@ bool TextFileHandler::createH2DrumkitXmlFile( const QString dirPath, const QStri
 
     docElement.addChildElement( instrumentListElement );
 
-    File file( QDir( dirPath ).absoluteFilePath( "drumkit.xml" ).toLocal8Bit().data() );
-
-    return docElement.writeToFile( file, String::empty );
+    docElement.writeToStream( stream, String::empty );
 }
 
 
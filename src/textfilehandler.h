@@ -76,16 +76,22 @@ public:
         bool isMonophonyEnabled;
     };
 
-    static bool createProjectXmlFile( QString filePath, const ProjectSettings& settings );
+    static void writeProjectXml( OutputStream& stream, const ProjectSettings& settings );
 
-    static bool readProjectXmlFile( QString filePath, ProjectSettings& settings );
+    static bool readProjectXml( InputStream& stream, ProjectSettings& settings );
 
 
 
     struct PathsConfig
     {
+        PathsConfig() :
+            projectStorage( -1 )
+        {
+        }
+
         QString tempDirPath;
         QStringList recentProjectPaths;
+        int projectStorage;     // An AudioFileHandler::ProjectStorage value, or -1 if not set
     };
 
     static bool createPathsConfigFile( const PathsConfig& config );
@@ -94,8 +100,8 @@ public:
 
 
 
-    static bool createH2DrumkitXmlFile( QString dirPath, QString kitName, QStringList audioFileNames,
-                                        const SamplerAudioSource::EnvelopeSettings& envelopes );
+    static void writeH2DrumkitXml( OutputStream& stream, QString kitName, QStringList audioFileNames,
+                                   const SamplerAudioSource::EnvelopeSettings& envelopes );
 
     static bool createSFZFile( QString sfzFilePath,
                                QString samplesDirName,
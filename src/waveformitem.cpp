@@ -22,6 +22,8 @@
 
 #include "waveformitem.h"
 #include "wavegraphicsscene.h"
+#include <QTimer>
+#include <QPixmapCache>
 #include <QtDebug>
 
 
@@ -38,8 +40,13 @@ WaveformItem::WaveformItem( const SharedSampleBuffer sampleBuffer,
     m_currentOrderPos( orderPos ),
     m_globalScaleFactor( NOT_SET ),
     m_stretchRatio( 1.0 ),
+    m_isWaitingForPeaks( false ),
+    m_isPeaksRefreshScheduled( false ),
     m_firstCalculatedBin( NOT_SET ),
-    m_lastCalculatedBin( NOT_SET )
+    m_lastCalculatedBin( NOT_SET ),
+    m_firstVertexBin( NOT_SET ),
+    m_lastVertexBin( NOT_SET ),
+    m_tileCacheId( s_nextTileCacheId++ )
 {
     setFlags( ItemIsMovable | ItemIsSelectable | ItemSendsGeometryChanges | ItemUsesExtendedStyleOption );
 
@@ -61,6 +68,9 @@ WaveformItem::WaveformItem( const SharedSampleBuffer sampleBuffer,
         m_minSampleValues.add( new Array<float> );
         m_maxSampleValues.add( new Array<float> );
     }
+
+    // Get the peaks ready in the background before the waveform is first drawn
+    m_sampleBuffer->preparePeaks();
 }
 
 
@@ -69,8 +79,6 @@ void WaveformItem::paint( QPainter* painter, const QStyleOptionGraphicsItem* opt
 {
     Q_UNUSED( widget );
 
-    const int numChans = m_sampleBuffer->getNumChannels();
-
     // If scale factor has changed since the last redraw then reset sample bins and establish new detail level
     if ( m_globalScaleFactor != painter->worldTransform().m11() )
     {
@@ -78,37 +86,18 @@ void WaveformItem::paint( QPainter* painter, const QStyleOptionGraphicsItem* opt
         resetSampleBins();
     }
 
-    // Draw rect background
-    painter->setPen( pen() );
-    painter->setBrush( brush() );
-    painter->drawRect( rect() );
+    // Draw the waveform from cached tiles, each TILE_WIDTH pixels wide at the current zoom level
+    const qreal tileWidth = TILE_WIDTH / m_globalScaleFactor;
 
-    // Scale waveform to fit size of rect
-    painter->save();
-    painter->scale( 1.0, rect().height() * 0.5 / numChans );
+    const int firstTileNum = qMax( (int) floor( option->exposedRect.left() / tileWidth ), 0 );
+    const int lastTileNum = (int) floor( qMin( option->exposedRect.right(), rect().right() ) / tileWidth );
 
-    // Draw centre line/lines
     painter->save();
-    painter->translate( 0.0, 1.0 );
-    painter->setPen( m_centreLinePen );
-    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
-    {
-        painter->drawLine( 0.0, 0.0, rect().width(), 0.0 );
-        painter->translate( 0.0, 1.0 * numChans );
-    }
-    painter->restore();
+    painter->scale( 1.0 / m_globalScaleFactor, 1.0 );
 
-    // Draw waveform
-    painter->translate( 0.0, 1.0 );
-    painter->setPen( m_wavePen );
-
-    if ( m_detailLevel != VERY_HIGH )
+    for ( int tileNum = firstTileNum; tileNum <= lastTileNum; tileNum++ )
     {
-        drawWaveformFromSampleBins( painter, option->exposedRect.left(), option->exposedRect.right() );
-    }
-    else
-    {
-        drawWaveformFromSamples( painter, option->exposedRect.left(), option->exposedRect.right() );
+        painter->drawPixmap( QPointF( tileNum * TILE_WIDTH, 0.0 ), getTile( tileNum ) );
     }
 
     painter->restore();
@@ -119,6 +108,13 @@ void WaveformItem::paint( QPainter* painter, const QStyleOptionGraphicsItem* opt
         painter->setBrush( QColor(255, 127, 127, 70) );
         painter->drawRect( rect() );
     }
+
+    // If some of the waveform couldn't be drawn yet then check back later
+    if ( m_isWaitingForPeaks && ! m_isPeaksRefreshScheduled )
+    {
+        QTimer::singleShot( PEAKS_REFRESH_INTERVAL, this, SLOT( refreshPeaks() ) );
+        m_isPeaksRefreshScheduled = true;
+    }
 }
 
 
@@ -261,16 +257,22 @@ void WaveformItem::mouseMoveEvent( QGraphicsSceneMouseEvent* event )
         const QPointF leftmostSelectedItemScenePos = selectedItems.first()->scenePos();
         const int leftmostSelectedItemOrderPos = selectedItems.first()->getOrderPos();
 
-        // Get item under left edge of the leftmost selected item
-        QGraphicsItem* const otherItem = scene->items( leftmostSelectedItemScenePos ).last();
+        // Get the item under the left edge of the leftmost selected item. It is looked up by order position,
+        // as items far from the viewport aren't in the scene
+        int otherItemOrderPos = leftmostSelectedItemOrderPos - 1;
 
-        // If the other item is a WaveformItem...
-        if ( otherItem != this && otherItem->type() == WaveformItem::Type )
+        while ( otherItemOrderPos >= 0 &&
+                scene->getWaveformAt( otherItemOrderPos )->scenePos().x() > leftmostSelectedItemScenePos.x() )
         {
-            WaveformItem* const otherWaveformItem = qgraphicsitem_cast<WaveformItem*>( otherItem );
-            const int otherItemOrderPos = otherWaveformItem->getOrderPos();
+            otherItemOrderPos--;
+        }
+
+        // If there is an item under the left edge...
+        if ( otherItemOrderPos >= 0 )
+        {
+            const SharedWaveformItem otherWaveformItem = scene->getWaveformAt( otherItemOrderPos );
 
-            if ( otherItemOrderPos < leftmostSelectedItemOrderPos )
+            if ( leftmostSelectedItemScenePos.x() < otherWaveformItem->scenePos().x() + otherWaveformItem->rect().width() )
             {
                 // If the left edge of the leftmost selected item is more than halfway across the other item
                 // then move the other item out of the way
@@ -298,16 +300,23 @@ void WaveformItem::mouseMoveEvent( QGraphicsSceneMouseEvent* event )
         const qreal rightmostSelectedItemRightEdge = selectedItems.last()->scenePos().x() +
                                                      selectedItems.last()->rect().width() - 1;
 
-        // Get item under right edge of the rightmost selected item
-        QGraphicsItem* const otherItem = scene->items( QPointF(rightmostSelectedItemRightEdge, BpmRuler::HEIGHT) ).last();
+        // Get the item under the right edge of the rightmost selected item. It is looked up by order position,
+        // as items far from the viewport aren't in the scene
+        int otherItemOrderPos = rightmostSelectedItemOrderPos + 1;
+
+        while ( otherItemOrderPos < scene->getNumWaveforms() &&
+                scene->getWaveformAt( otherItemOrderPos )->scenePos().x() +
+                scene->getWaveformAt( otherItemOrderPos )->rect().width() <= rightmostSelectedItemRightEdge )
+        {
+            otherItemOrderPos++;
+        }
 
-        // If the other item is a WaveformItem...
-        if ( otherItem != this && otherItem->type() == WaveformItem::Type )
+        // If there is an item under the right edge...
+        if ( otherItemOrderPos < scene->getNumWaveforms() )
         {
-            WaveformItem* const otherWaveformItem = qgraphicsitem_cast<WaveformItem*>( otherItem );
-            const int otherItemOrderPos = otherWaveformItem->getOrderPos();
+            const SharedWaveformItem otherWaveformItem = scene->getWaveformAt( otherItemOrderPos );
 
-            if ( otherItemOrderPos > rightmostSelectedItemOrderPos )
+            if ( rightmostSelectedItemRightEdge >= otherWaveformItem->scenePos().x() )
             {
                 // If the right edge of the rightmost selected item is more than halfway across the other item
                 // then move the other item out of the way
@@ -375,12 +384,101 @@ void WaveformItem::setBackgroundGradient()
 
 
 
+QPixmap WaveformItem::getTile( const int tileNum )
+{
+    const QString key = QString( "waveform:%1:%2" ).arg( m_tileCacheId ).arg( tileNum );
+
+    QPixmap pixmap;
+
+    if ( ! QPixmapCache::find( key, &pixmap ) )
+    {
+        pixmap = renderTile( tileNum );
+
+        // Tiles with gaps still to be filled in are drawn again when the peaks are refreshed
+        QPixmapCache::insert( key, pixmap );
+    }
+
+    return pixmap;
+}
+
+
+
+QPixmap WaveformItem::renderTile( const int tileNum )
+{
+    const qreal tileWidth = TILE_WIDTH / m_globalScaleFactor;
+    const qreal tileLeft = tileNum * tileWidth;
+
+    QPixmap pixmap( TILE_WIDTH, (int) ceil( rect().height() ) );
+    pixmap.fill( Qt::transparent );
+
+    QPainter painter( &pixmap );
+    painter.setRenderHint( QPainter::Antialiasing, true );
+    painter.scale( m_globalScaleFactor, 1.0 );
+    painter.translate( -tileLeft, 0.0 );
+
+    drawContents( &painter, tileLeft, qMin( tileLeft + tileWidth, rect().right() ) );
+
+    return pixmap;
+}
+
+
+
+void WaveformItem::drawContents( QPainter* const painter, const qreal left, const qreal right )
+{
+    const int numChans = m_sampleBuffer->getNumChannels();
+
+    // Draw rect background
+    painter->setPen( pen() );
+    painter->setBrush( brush() );
+    painter->drawRect( rect() );
+
+    // Scale waveform to fit size of rect
+    painter->save();
+    painter->scale( 1.0, rect().height() * 0.5 / numChans );
+
+    // Draw centre line/lines
+    painter->save();
+    painter->translate( 0.0, 1.0 );
+    painter->setPen( m_centreLinePen );
+    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
+    {
+        painter->drawLine( QPointF( left, 0.0 ), QPointF( right, 0.0 ) );
+        painter->translate( 0.0, 1.0 * numChans );
+    }
+    painter->restore();
+
+    // Draw waveform
+    painter->translate( 0.0, 1.0 );
+    painter->setPen( m_wavePen );
+
+    if ( m_detailLevel != VERY_HIGH )
+    {
+        drawWaveformFromSampleBins( painter, left, right );
+    }
+    else
+    {
+        drawWaveformFromSamples( painter, left, right );
+    }
+
+    painter->restore();
+}
+
+
+
 void WaveformItem::resetSampleBins()
 {
     const int numChans = m_sampleBuffer->getNumChannels();
 
     m_firstCalculatedBin = NOT_SET;
     m_lastCalculatedBin = NOT_SET;
+    m_firstVertexBin = NOT_SET;
+    m_lastVertexBin = NOT_SET;
+
+    // Stop using any tiles drawn at the old zoom level or from old sample data
+    m_tileCacheId = s_nextTileCacheId++;
+
+    // The sample data may have been modified, in which case its peaks will need building again
+    m_sampleBuffer->preparePeaks();
 
     m_numBins = rect().width() * m_globalScaleFactor;
     m_binSize = (qreal) m_sampleBuffer->getNumFrames() / ( rect().width() * m_globalScaleFactor );
@@ -427,17 +525,57 @@ void WaveformItem::resetSampleBins()
 void WaveformItem::findMinMaxSamples( const int startBin, const int endBin )
 {
     const int numChans = m_sampleBuffer->getNumChannels();
+    const int numFrames = m_sampleBuffer->getNumFrames();
+    const SampleEditChain& edits = m_sampleBuffer->getEdits();
 
     for ( int chanNum = 0; chanNum < numChans; chanNum++ )
     {
         for ( int binNum = startBin; binNum <= endBin; binNum++ )
         {
-            Range<float> range = m_sampleBuffer->findMinMax( chanNum,
-                                                            int( binNum * m_binSize ),
-                                                            int( m_binSize ) );
+            // Each bin covers all the frames up to the start of the next bin. At the low detail level each bin also
+            // includes the last frame of the previous bin so that the lines of neighbouring bins join up
+            int startFrame = int( binNum * m_binSize );
+            const int endFrame = qMin( int( (binNum + 1) * m_binSize ), numFrames );
+
+            if ( m_detailLevel == LOW && startFrame > 0 )
+            {
+                startFrame--;
+            }
+
+            const int binSize = qMax( endFrame - startFrame, 1 );
+            float gain = 1.0f;
+
+            // Find the range of unedited frames covered by this bin; the gain is taken from the bin's centre
+            if ( ! edits.isEmpty() )
+            {
+                qreal firstFramePos = startFrame;
+                qreal lastFramePos = startFrame + binSize - 1;
+                qreal centreFramePos = startFrame + binSize * 0.5;
+
+                edits.mapFramePos( firstFramePos, numFrames );
+                edits.mapFramePos( lastFramePos, numFrames );
+                gain = edits.mapFramePos( centreFramePos, numFrames );
 
-            m_minSampleValues[ chanNum ]->set( binNum, range.getStart() );
-            m_maxSampleValues[ chanNum ]->set( binNum, range.getEnd() );
+                startFrame = qMax( (int) qMin( firstFramePos, lastFramePos ), 0 );
+            }
+
+            // Leave the bin empty until its peaks are ready, rather than holding up the GUI thread
+            Range<float> range;
+
+            if ( m_sampleBuffer->arePeaksReady( startFrame, binSize ) )
+            {
+                range = m_sampleBuffer->findPeaks( chanNum, startFrame, binSize );
+            }
+            else
+            {
+                m_isWaitingForPeaks = true;
+            }
+
+            const float min = range.getStart() * gain;
+            const float max = range.getEnd() * gain;
+
+            m_minSampleValues[ chanNum ]->set( binNum, qMin( min, max ) );
+            m_maxSampleValues[ chanNum ]->set( binNum, qMax( min, max ) );
         }
     }
 }
@@ -450,6 +588,11 @@ void WaveformItem::drawWaveformFromSampleBins( QPainter* painter, qreal exposedR
     const int firstVisibleBin = qMax( (int) floor( exposedRectLeft * m_globalScaleFactor ), 0 );
     const int lastVisibleBin = qMin( (int) ceil( exposedRectRight * m_globalScaleFactor ), m_numBins - 1 );
 
+    if ( lastVisibleBin < firstVisibleBin )
+    {
+        return;
+    }
+
     if ( m_firstCalculatedBin == NOT_SET || m_lastCalculatedBin == NOT_SET )
     {
         findMinMaxSamples( firstVisibleBin, lastVisibleBin );
@@ -471,10 +614,15 @@ void WaveformItem::drawWaveformFromSampleBins( QPainter* painter, qreal exposedR
 
     const int numVisibleBins = lastVisibleBin - firstVisibleBin + 1;
 
-    const qreal reciprocalScaleFactor = 1.0 / m_globalScaleFactor;
-
     const int numChans = m_sampleBuffer->getNumChannels();
 
+    // The vertices only need updating when different bins come into view or the bins are recalculated
+    if ( firstVisibleBin != m_firstVertexBin || lastVisibleBin != m_lastVertexBin )
+    {
+        updateBinVertices( firstVisibleBin, lastVisibleBin );
+    }
+
+    // Each channel is drawn with a single call so that the OpenGL paint engine can send all its vertices at once
     if ( m_detailLevel == LOW )
     {
 #if QT_VERSION < 0x040700  // Qt 4.6 or less
@@ -483,18 +631,7 @@ void WaveformItem::drawWaveformFromSampleBins( QPainter* painter, qreal exposedR
 
         for ( int chanNum = 0; chanNum < numChans; chanNum++ )
         {
-            for ( int count = 0; count < numVisibleBins; count++ )
-            {
-                const float min = (*m_minSampleValues[ chanNum ])[ firstVisibleBin + count ];
-                const float max = (*m_maxSampleValues[ chanNum ])[ firstVisibleBin + count ];
-
-                painter->drawLine
-                (
-                    QPointF( (firstVisibleBin + count) * reciprocalScaleFactor, -min ),
-                    QPointF( (firstVisibleBin + count) * reciprocalScaleFactor, -max )
-                );
-            }
-
+            painter->drawLines( m_binVertices.constData() + chanNum * numVisibleBins * 2, numVisibleBins );
             painter->translate( 0.0, numChans );
         }
     }
@@ -506,56 +643,144 @@ void WaveformItem::drawWaveformFromSampleBins( QPainter* painter, qreal exposedR
 
         for ( int chanNum = 0; chanNum < numChans; chanNum++ )
         {
-            QPointF points[ numVisibleBins * 2 ];
+            painter->drawPolyline( m_binVertices.constData() + chanNum * numVisibleBins * 2, numVisibleBins * 2 );
+            painter->translate( 0.0, numChans );
+        }
+    }
+}
 
-            for ( int count = 0; count < numVisibleBins; count++ )
-            {
-                const float min = (*m_minSampleValues[ chanNum ])[ firstVisibleBin + count ];
-                const float max = (*m_maxSampleValues[ chanNum ])[ firstVisibleBin + count ];
 
-                points[ count * 2 ]       = QPointF( (firstVisibleBin + count) * reciprocalScaleFactor, -min );
-                points[ (count * 2) + 1 ] = QPointF( (firstVisibleBin + count) * reciprocalScaleFactor, -max );
-            }
 
-            painter->drawPolyline( points, numVisibleBins * 2 );
-            painter->translate( 0.0, numChans );
+void WaveformItem::updateBinVertices( const int firstBin, const int lastBin )
+{
+    const int numBins = lastBin - firstBin + 1;
+    const int numChans = m_sampleBuffer->getNumChannels();
+
+    const qreal reciprocalScaleFactor = 1.0 / m_globalScaleFactor;
+
+    // A vertical line from min to max for each bin; the vector's capacity is kept between updates
+    m_binVertices.resize( numChans * numBins * 2 );
+
+    QPointF* vertex = m_binVertices.data();
+
+    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
+    {
+        const float* const minValues = m_minSampleValues[ chanNum ]->getRawDataPointer();
+        const float* const maxValues = m_maxSampleValues[ chanNum ]->getRawDataPointer();
+
+        for ( int binNum = firstBin; binNum <= lastBin; binNum++ )
+        {
+            const qreal x = binNum * reciprocalScaleFactor;
+
+            *vertex++ = QPointF( x, -minValues[ binNum ] );
+            *vertex++ = QPointF( x, -maxValues[ binNum ] );
         }
     }
+
+    m_firstVertexBin = firstBin;
+    m_lastVertexBin = lastBin;
 }
 
 
 
 void WaveformItem::drawWaveformFromSamples( QPainter* const painter, const qreal exposedRectLeft, const qreal exposedRectRight )
 {
-    const qreal distanceBetweenFrames = rect().width() / m_sampleBuffer->getNumFrames();
+    // Leave the waveform out until the sample data has been loaded
+    if ( ! m_sampleBuffer->isLoaded() )
+    {
+        m_isWaitingForPeaks = true;
+        return;
+    }
 
-    const int firstVisibleFrame = (int) floor( exposedRectLeft / distanceBetweenFrames );
+    const int numFrames = m_sampleBuffer->getNumFrames();
+    const qreal distanceBetweenFrames = rect().width() / numFrames;
 
-    const int lastVisibleFrame = qMin( (int) ceil( exposedRectRight / distanceBetweenFrames ),
-                                       m_sampleBuffer->getNumFrames() - 1 );
+    // There is at most one frame per pixel at this detail level, so the no. of points is bounded by the exposed
+    // width. The frames either side of the exposed rect are included so that the lines reach its edges
+    const int firstVisibleFrame = qMax( (int) floor( exposedRectLeft / distanceBetweenFrames ), 0 );
+    const int lastVisibleFrame = qMin( (int) ceil( exposedRectRight / distanceBetweenFrames ), numFrames - 1 );
+
+    if ( lastVisibleFrame < firstVisibleFrame )
+    {
+        return;
+    }
 
     const int numVisibleFrames = lastVisibleFrame - firstVisibleFrame + 1;
 
     const int numChans = m_sampleBuffer->getNumChannels();
 
+    const SampleEditChain& edits = m_sampleBuffer->getEdits();
+
+    // The vector's capacity is kept between paints
+    m_sampleVertices.resize( numVisibleFrames );
+
 #if QT_VERSION < 0x040700  // Qt 4.6 or less
     painter->setRenderHint( QPainter::Antialiasing, true );
 #endif
 
+    painter->save();
+    painter->setClipRect( QRectF( exposedRectLeft, -1.0, exposedRectRight - exposedRectLeft, 2.0 * numChans ) );
+
     for ( int chanNum = 0; chanNum < numChans; chanNum++ )
     {
-        QPointF points[ numVisibleFrames ];
+        QPointF* const points = m_sampleVertices.data();
 
-        const float* sampleData = m_sampleBuffer->getReadPointer( chanNum, firstVisibleFrame );
+        if ( edits.isEmpty() )
+        {
+            const float* sampleData = m_sampleBuffer->getReadPointer( chanNum, firstVisibleFrame );
 
-        for ( int count = 0; count < numVisibleFrames; count++ )
+            for ( int count = 0; count < numVisibleFrames; count++ )
+            {
+                points[ count ] = QPointF( (firstVisibleFrame + count) * distanceBetweenFrames,
+                                           -(*sampleData) );
+                sampleData++;
+            }
+        }
+        else
         {
-            points[ count ] = QPointF( (firstVisibleFrame + count) * distanceBetweenFrames,
-                                       -(*sampleData) );
-            sampleData++;
+            const float* const sampleData = m_sampleBuffer->getReadPointer( chanNum );
+
+            for ( int count = 0; count < numVisibleFrames; count++ )
+            {
+                qreal framePos = firstVisibleFrame + count;
+                const float gain = edits.mapFramePos( framePos, numFrames );
+
+                points[ count ] = QPointF( (firstVisibleFrame + count) * distanceBetweenFrames,
+                                           -( sampleData[ (int) framePos ] * gain ) );
+            }
         }
 
         painter->drawPolyline( points, numVisibleFrames );
         painter->translate( 0.0, numChans );
     }
+
+    painter->restore();
+}
+
+
+
+//==================================================================================================
+// Private Static:
+
+quint64 WaveformItem::s_nextTileCacheId = 0;
+
+
+
+//==================================================================================================
+// Private Slots:
+
+void WaveformItem::refreshPeaks()
+{
+    m_isPeaksRefreshScheduled = false;
+    m_isWaitingForPeaks = false;
+
+    // Recalculate all visible bins, including any that were left empty
+    m_firstCalculatedBin = NOT_SET;
+    m_lastCalculatedBin = NOT_SET;
+    m_firstVertexBin = NOT_SET;
+    m_lastVertexBin = NOT_SET;
+
+    m_tileCacheId = s_nextTileCacheId++;
+
+    update();
 }
@@ -30,6 +30,7 @@
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
 #include <QList>
+#include <QVector>
 #include "JuceHeader.h"
 #include "samplebuffer.h"
 #include "globals.h"
@@ -77,12 +78,23 @@ protected:
 private:
     void setBackgroundGradient();
 
+    // Returns a tile of the rendered waveform, drawing it only if it isn't already cached
+    QPixmap getTile( int tileNum );
+    QPixmap renderTile( int tileNum );
+
+    // Draws the background, centre lines and waveform between item coordinates 'left' and 'right'
+    void drawContents( QPainter* painter, qreal left, qreal right );
+
     void resetSampleBins();
 
     // Both 'startBin' and 'endBin' are inclusive
     void findMinMaxSamples( int startBin, int endBin );
 
     void drawWaveformFromSampleBins( QPainter* painter, qreal exposedRectLeft, qreal exposedRectRight );
+
+    // Both 'firstBin' and 'lastBin' are inclusive
+    void updateBinVertices( int firstBin, int lastBin );
+
     void drawWaveformFromSamples( QPainter* painter, qreal exposedRectLeft, qreal exposedRectRight );
 
     enum DetailLevel { LOW, HIGH, VERY_HIGH };
@@ -100,6 +112,11 @@ private:
 
     qreal m_stretchRatio;
 
+    // Set when bins have been left empty because the peaks for their frames aren't ready yet,
+    // or the sample data itself is still being loaded
+    bool m_isWaitingForPeaks;
+    bool m_isPeaksRefreshScheduled;
+
     int m_numBins;
     qreal m_binSize;
     int m_firstCalculatedBin;
@@ -107,11 +124,25 @@ private:
     OwnedArray< Array<float> > m_minSampleValues;
     OwnedArray< Array<float> > m_maxSampleValues;
 
+    // Vertices of the visible bins of all channels, one channel after another
+    QVector<QPointF> m_binVertices;
+    int m_firstVertexBin;
+    int m_lastVertexBin;
+
+    // Points of one channel of the visible frames, used at the very high detail level
+    QVector<QPointF> m_sampleVertices;
+
+    // Identifies this item's tiles in the global pixmap cache; changed whenever the tiles need to be redrawn
+    quint64 m_tileCacheId;
+    static quint64 s_nextTileCacheId;
+
 private:
     static const int NOT_SET = -1;
     static constexpr qreal DETAIL_LEVEL_MAX_CUTOFF = 0.05;
     static constexpr qreal DETAIL_LEVEL_VERY_HIGH_CUTOFF = 1.0;
     static constexpr qreal DETAIL_LEVEL_HIGH_CUTOFF = 10.0;
+    static const int PEAKS_REFRESH_INTERVAL = 100; // Milliseconds
+    static const int TILE_WIDTH = 256; // Pixels
 
 signals:
     // As waveform items are being dragged, their old order positions are emitted along with
@@ -134,6 +165,9 @@ signals:
     void sampleDetailLevelReached();
     void maxDetailLevelReached();
 
+private slots:
+    void refreshPeaks();
+
 private:
     JUCE_LEAK_DETECTOR( WaveformItem );
 };
@@ -32,31 +32,14 @@
 WaveGraphicsScene::WaveGraphicsScene( const qreal x, const qreal y, const qreal width, const qreal height, QObject* parent ) :
     QGraphicsScene( x, y, width, height, parent ),
     m_interactionMode( AUDITION_ITEMS ),
+    m_isPlayheadScrolling( false ),
+    m_playheadStartPosX( 0.0 ),
+    m_playheadEndPosX( 0.0 ),
+    m_playheadPosX( 0.0 ),
+    m_playheadNumFrames( 0 ),
     m_isSceneAtSampleDetailLevel( false )
 {
     createBpmRuler();
-
-    // Set up playhead
-    m_playhead = new QGraphicsLineItem( 0.0, 0.0, 0.0, height - BpmRuler::HEIGHT );
-    QPen pen = QPen( Qt::red );
-    pen.setCosmetic( true );
-    m_playhead->setPen( pen );
-    m_playhead->setZValue( ZValues::PLAYHEAD );
-
-    m_timer = new QTimeLine();
-    m_timer->setFrameRange( 0, 100 );
-    m_timer->setCurveShape( QTimeLine::LinearCurve );
-    m_timer->setUpdateInterval( 17 ); // 17ms - roughly 60 fps
-
-    m_animation = new QGraphicsItemAnimation;
-    m_animation->setItem( m_playhead );
-    m_animation->setTimeLine( m_timer );
-
-    QObject::connect( m_timer, SIGNAL( finished() ),
-                      this, SLOT( removePlayhead() ) );
-
-    QObject::connect( m_timer, SIGNAL( finished() ),
-                      this, SIGNAL( playheadFinishedScrolling() ) );
 }
 
 
@@ -200,11 +183,8 @@ void WaveGraphicsScene::insertWaveforms( const QList<SharedWaveformItem> wavefor
         scenePosX += itemWidth;
     }
 
-    // Add waveform items to scene
-    foreach ( SharedWaveformItem item, waveformItems )
-    {
-        addItem( item.data() );
-    }
+    // Add those waveform items that can be seen to scene
+    updateVisibleItems();
     update();
 
     setInteractionMode( m_interactionMode );
@@ -224,7 +204,7 @@ QList<SharedWaveformItem> WaveGraphicsScene::removeWaveforms( const QList<int> w
         SharedWaveformItem item = m_waveformItemList.at( startOrderPos );
 
         m_waveformItemList.removeAt( startOrderPos );
-        removeItem( item.data() );
+        removeVisibleItem( item.data() );
 
         removedWaveforms << item;
     }
@@ -253,6 +233,8 @@ QList<SharedWaveformItem> WaveGraphicsScene::removeWaveforms( const QList<int> w
         scenePosX += itemWidth;
     }
 
+    updateVisibleItems();
+
     return removedWaveforms;
 }
 
@@ -309,10 +291,12 @@ void WaveGraphicsScene::selectNextWaveform()
             orderPos = 0;
         }
 
+        addVisibleItem( m_waveformItemList.at( orderPos ).data() );
         m_waveformItemList.at( orderPos )->setSelected( true );
     }
     else
     {
+        addVisibleItem( m_waveformItemList.first().data() );
         m_waveformItemList.first()->setSelected( true );
     }
 }
@@ -337,10 +321,12 @@ void WaveGraphicsScene::selectPreviousWaveform()
             orderPos = m_waveformItemList.size() - 1;
         }
 
+        addVisibleItem( m_waveformItemList.at( orderPos ).data() );
         m_waveformItemList.at( orderPos )->setSelected( true );
     }
     else
     {
+        addVisibleItem( m_waveformItemList.last().data() );
         m_waveformItemList.last()->setSelected( true );
     }
 }
@@ -417,11 +403,16 @@ SharedSlicePointItem WaveGraphicsScene::createSlicePoint( const int frameNum, co
     QObject::connect( item, SIGNAL( scenePosChanged(SlicePointItem*,int) ),
                       this, SLOT( updateSlicePointOrdering(SlicePointItem*,int) ) );
 
-    addItem( item );
+    const QRectF visibleItemsRect = getVisibleItemsRect();
+
+    if ( scenePosX >= visibleItemsRect.left() && scenePosX <= visibleItemsRect.right() )
+    {
+        addVisibleItem( item );
+    }
     update();
 
     SharedSlicePointItem sharedSlicePoint = SharedSlicePointItem( item );
-    m_slicePointItemList.append( sharedSlicePoint );
+    m_slicePointItemList.insert( getSlicePointInsertIndex( frameNum ), sharedSlicePoint );
 
     return sharedSlicePoint;
 }
@@ -441,9 +432,14 @@ void WaveGraphicsScene::addSlicePoint( const SharedSlicePointItem slicePoint )
     slicePoint.data()->setHeight( height() - BpmRuler::HEIGHT );
     slicePoint.data()->setPos( scenePosX, BpmRuler::HEIGHT );
 
-    m_slicePointItemList.append( slicePoint );
+    m_slicePointItemList.insert( getSlicePointInsertIndex( slicePointFrameNum ), slicePoint );
 
-    addItem( slicePoint.data() );
+    const QRectF visibleItemsRect = getVisibleItemsRect();
+
+    if ( scenePosX >= visibleItemsRect.left() && scenePosX <= visibleItemsRect.right() )
+    {
+        addVisibleItem( slicePoint.data() );
+    }
     update();
 }
 
@@ -451,10 +447,19 @@ void WaveGraphicsScene::addSlicePoint( const SharedSlicePointItem slicePoint )
 
 void WaveGraphicsScene::removeSlicePoint( const SharedSlicePointItem slicePointItem )
 {
-    removeItem( slicePointItem.data() );
+    removeVisibleItem( slicePointItem.data() );
     update();
 
-    m_slicePointItemList.removeOne( slicePointItem );
+    const int index = getSlicePointIndex( slicePointItem.data(), slicePointItem->getFrameNum() );
+
+    if ( index >= 0 )
+    {
+        m_slicePointItemList.removeAt( index );
+    }
+    else
+    {
+        m_slicePointItemList.removeOne( slicePointItem );
+    }
 }
 
 
@@ -463,8 +468,19 @@ void WaveGraphicsScene::moveSlicePoint( const SharedSlicePointItem slicePointIte
 {
     const qreal newScenePosX = getScenePosX( newFrameNum );
 
+    const int index = getSlicePointIndex( slicePointItem.data(), slicePointItem->getFrameNum() );
+
     slicePointItem->setFrameNum( newFrameNum );
     slicePointItem->setPos( newScenePosX, BpmRuler::HEIGHT );
+
+    // Move the item to its new place in the sorted list
+    if ( index >= 0 )
+    {
+        m_slicePointItemList.removeAt( index );
+        m_slicePointItemList.insert( getSlicePointInsertIndex( newFrameNum ), slicePointItem );
+    }
+
+    updateVisibleItems();
 }
 
 
@@ -507,13 +523,29 @@ QList<int> WaveGraphicsScene::getSlicePointFrameNums() const
         slicePointFrameNums.append( slicePointItem->getFrameNum() );
     }
 
-    qSort( slicePointFrameNums );
-
     return slicePointFrameNums;
 }
 
 
 
+SharedSlicePointItem WaveGraphicsScene::getPrevSlicePoint( const SlicePointItem* const slicePointItem ) const
+{
+    const int index = getSlicePointIndex( slicePointItem, slicePointItem->getFrameNum() );
+
+    return index > 0 ? m_slicePointItemList.at( index - 1 ) : SharedSlicePointItem();
+}
+
+
+
+SharedSlicePointItem WaveGraphicsScene::getNextSlicePoint( const SlicePointItem* const slicePointItem ) const
+{
+    const int index = getSlicePointIndex( slicePointItem, slicePointItem->getFrameNum() );
+
+    return index >= 0 && index < m_slicePointItemList.size() - 1 ? m_slicePointItemList.at( index + 1 ) : SharedSlicePointItem();
+}
+
+
+
 void WaveGraphicsScene::selectNone()
 {
     foreach ( SharedSlicePointItem item, m_slicePointItemList )
@@ -533,107 +565,103 @@ void WaveGraphicsScene::selectAll()
 {
     foreach ( SharedWaveformItem item, m_waveformItemList )
     {
+        addVisibleItem( item.data() );
         item->setSelected( true );
     }
 }
 
 
 
-void WaveGraphicsScene::startPlayhead( const bool isLoopingDesired, const qreal stretchRatio )
+void WaveGraphicsScene::startPlayhead()
 {
-    const int numFrames = getTotalNumFrames( m_waveformItemList );
-
-    const qreal startPosX = 0.0;
-    const qreal endPosX   = width() - 1;
-
-    startPlayhead( startPosX, endPosX, numFrames, isLoopingDesired, stretchRatio );
+    startPlayhead( 0.0, width() - 1, getTotalNumFrames( m_waveformItemList ) );
 }
 
 
 
-void WaveGraphicsScene::startPlayhead( const qreal startPosX,
-                                       const qreal endPosX,
-                                       const int numFrames,
-                                       const bool isLoopingDesired,
-                                       const qreal stretchRatio )
+void WaveGraphicsScene::startPlayhead( const qreal startPosX, const qreal endPosX, const int numFrames )
 {
-    const qreal sampleRate = m_sampleHeader->sampleRate;
+    stopPlayhead();
 
-    if ( sampleRate > 0.0 )
-    {
-        const int millis = roundToIntAccurate( (numFrames / sampleRate) * 1000 * stretchRatio );
+    m_playheadStartPosX = startPosX;
+    m_playheadEndPosX = endPosX;
+    m_playheadPosX = startPosX;
+    m_playheadNumFrames = numFrames;
+    m_isPlayheadScrolling = true;
 
-        if ( isPlayheadScrolling() )
-        {
-            stopPlayhead();
-        }
+    updatePlayheadArea( m_playheadPosX );
+}
 
-        m_animation->setPosAt( 0.0, QPointF( startPosX, BpmRuler::HEIGHT ) );
-        m_animation->setPosAt( 1.0, QPointF( endPosX,   BpmRuler::HEIGHT ) );
 
-        m_playhead->setLine( 0.0, 0.0, 0.0, height() - BpmRuler::HEIGHT );
-        m_playhead->setVisible( true );
-        addItem( m_playhead );
 
-        if ( isLoopingDesired )
-        {
-            m_timer->setLoopCount( 0 );
-        }
-        else
-        {
-            m_timer->setLoopCount( 1 );
-        }
-        m_timer->setDuration( millis );
-        m_timer->start();
+void WaveGraphicsScene::updatePlayhead( const int frameNum )
+{
+    if ( ! m_isPlayheadScrolling || m_playheadNumFrames <= 0 )
+    {
+        return;
     }
-}
 
+    const int clampedFrameNum = qBound( 0, frameNum, m_playheadNumFrames );
 
+    const qreal newPosX = m_playheadStartPosX +
+                          ( m_playheadEndPosX - m_playheadStartPosX ) * clampedFrameNum / m_playheadNumFrames;
 
-void WaveGraphicsScene::stopPlayhead()
-{
-    if ( isPlayheadScrolling() )
+    // Don't repaint unless the playhead has moved by at least a pixel
+    const qreal scaleFactorX = views().isEmpty() ? 1.0 : views().first()->transform().m11();
+
+    if ( qAbs( newPosX - m_playheadPosX ) * scaleFactorX >= 1.0 )
     {
-        m_timer->stop();
-        removePlayhead();
+        updatePlayheadArea( m_playheadPosX );
+        m_playheadPosX = newPosX;
+        updatePlayheadArea( m_playheadPosX );
     }
 }
 
 
 
-void WaveGraphicsScene::setPlayheadLooping( const bool isLoopingDesired )
+void WaveGraphicsScene::stopPlayhead()
 {
-    if ( isLoopingDesired )
-    {
-        m_timer->setLoopCount( 0 );
-    }
-    else
+    if ( m_isPlayheadScrolling )
     {
-        m_timer->setLoopCount( 1 );
+        m_isPlayheadScrolling = false;
+        updatePlayheadArea( m_playheadPosX );
     }
 }
 
 
 
-void WaveGraphicsScene::updatePlayheadSpeed( const qreal stretchRatio )
+SharedGraphicsItem WaveGraphicsScene::getNearestBpmRulerMark( const qreal scenePosX ) const
 {
-    if ( isPlayheadScrolling() )
+    if ( m_rulerMarksList.isEmpty() )
     {
-        m_playhead->setVisible( false );
+        return SharedGraphicsItem();
+    }
 
-        m_timer->stop();
+    // Find the first ruler mark at or after 'scenePosX'
+    int low = 0;
+    int high = m_rulerMarksList.size();
 
-        const qreal sampleRate = m_sampleHeader->sampleRate;
-        const int numFrames = getTotalNumFrames( m_waveformItemList );
+    while ( low < high )
+    {
+        const int mid = ( low + high ) / 2;
 
-        const int newDuration = roundToInt( (numFrames / sampleRate) * 1000 * stretchRatio );
-//        const int newTime = roundToInt( mTimer->currentTime() * stretchRatio );
+        if ( m_rulerMarksList.at( mid )->scenePos().x() < scenePosX )
+            low = mid + 1;
+        else
+            high = mid;
+    }
 
-        m_timer->setDuration( newDuration );
-//        mTimer->setCurrentTime( newTime );
+    if ( low == m_rulerMarksList.size() )
+    {
+        return m_rulerMarksList.last();
+    }
 
-        m_timer->resume();
+    if ( low > 0 && scenePosX - m_rulerMarksList.at( low - 1 )->scenePos().x() < m_rulerMarksList.at( low )->scenePos().x() - scenePosX )
+    {
+        return m_rulerMarksList.at( low - 1 );
     }
+
+    return m_rulerMarksList.at( low );
 }
 
 
@@ -732,6 +760,7 @@ void WaveGraphicsScene::clearAll()
 
     m_waveformItemList.clear();
     m_slicePointItemList.clear();
+    m_visibleItems.clear();
     m_rulerMarksList.clear();
 
     createBpmRuler();
@@ -746,6 +775,7 @@ void WaveGraphicsScene::clearWaveform()
         if ( item->type() == WaveformItem::Type )
         {
             removeItem( item );
+            m_visibleItems.remove( item );
         }
     }
     update();
@@ -846,20 +876,11 @@ void WaveGraphicsScene::resizeSlicePointItems( const qreal scaleFactorX )
 
 
 
-void WaveGraphicsScene::resizePlayhead()
+void WaveGraphicsScene::resizePlayhead( const qreal scaleFactorX )
 {
-    if ( m_timer->state() == QTimeLine::Running )
-    {
-        m_timer->stop();
-
-        //m_animation->clear();
-        //m_animation->setPosAt( 0.0, QPointF( 0.0, BpmRuler::HEIGHT ) );
-        //m_animation->setPosAt( 1.0, QPointF( width() - 1, BpmRuler::HEIGHT ) );
-
-        m_playhead->setLine( 0.0, 0.0, 0.0, height() - BpmRuler::HEIGHT );
-
-        m_timer->resume();
-    }
+    m_playheadStartPosX *= scaleFactorX;
+    m_playheadEndPosX *= scaleFactorX;
+    m_playheadPosX *= scaleFactorX;
 }
 
 
@@ -898,6 +919,103 @@ void WaveGraphicsScene::scaleItems( const qreal scaleFactorX )
 
 
 
+void WaveGraphicsScene::updateVisibleItems()
+{
+    const QRectF visibleItemsRect = getVisibleItemsRect();
+
+    QSet<QGraphicsItem*> visibleItems;
+
+    // Waveform items are in scene position order so find the first one that can be seen using a binary search
+    int low = 0;
+    int high = m_waveformItemList.size();
+
+    while ( low < high )
+    {
+        const int mid = ( low + high ) / 2;
+        const SharedWaveformItem item = m_waveformItemList.at( mid );
+
+        if ( item->scenePos().x() + item->rect().width() < visibleItemsRect.left() )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    for ( int i = low; i < m_waveformItemList.size(); i++ )
+    {
+        WaveformItem* const item = m_waveformItemList.at( i ).data();
+
+        if ( item->scenePos().x() > visibleItemsRect.right() )
+        {
+            break;
+        }
+
+        visibleItems << item;
+    }
+
+    // Slice point items are in frame order
+    if ( ! m_waveformItemList.isEmpty() )
+    {
+        const int lastFrameNum = getFrameNum( visibleItemsRect.right() );
+
+        for ( int i = getSlicePointInsertIndex( getFrameNum( visibleItemsRect.left() ) ); i < m_slicePointItemList.size(); i++ )
+        {
+            SlicePointItem* const item = m_slicePointItemList.at( i ).data();
+
+            if ( item->getFrameNum() > lastFrameNum )
+            {
+                break;
+            }
+
+            visibleItems << item;
+        }
+    }
+
+    // Remove items that have gone out of range, unless Qt needs them to stay in the scene to move or deselect them
+    foreach ( QGraphicsItem* item, m_visibleItems )
+    {
+        if ( ! visibleItems.contains( item ) )
+        {
+            if ( item->isSelected() || item == mouseGrabberItem() )
+            {
+                visibleItems << item;
+            }
+            else
+            {
+                removeItem( item );
+            }
+        }
+    }
+
+    foreach ( QGraphicsItem* item, visibleItems )
+    {
+        if ( item->scene() != this )
+        {
+            addItem( item );
+        }
+    }
+
+    m_visibleItems = visibleItems;
+}
+
+
+
+//==================================================================================================
+// Protected:
+
+void WaveGraphicsScene::drawForeground( QPainter* const painter, const QRectF& rect )
+{
+    if ( m_isPlayheadScrolling && m_playheadPosX >= rect.left() - 1.0 && m_playheadPosX <= rect.right() + 1.0 )
+    {
+        QPen pen( Qt::red );
+        pen.setCosmetic( true );
+
+        painter->setPen( pen );
+        painter->drawLine( QPointF( m_playheadPosX, BpmRuler::HEIGHT ), QPointF( m_playheadPosX, height() ) );
+    }
+}
+
+
+
 //==================================================================================================
 // Private:
 
@@ -942,6 +1060,125 @@ void WaveGraphicsScene::createBpmRuler()
 
 
 
+int WaveGraphicsScene::getSlicePointInsertIndex( const int frameNum ) const
+{
+    int low = 0;
+    int high = m_slicePointItemList.size();
+
+    while ( low < high )
+    {
+        const int mid = ( low + high ) / 2;
+
+        if ( m_slicePointItemList.at( mid )->getFrameNum() < frameNum )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+
+
+int WaveGraphicsScene::getSlicePointIndex( const SlicePointItem* const slicePointItem, const int frameNum ) const
+{
+    // Binary search for the first slice point at 'frameNum', treating the item being searched for as still being at
+    // 'frameNum', then check each slice point at that frame no. in turn
+    int low = 0;
+    int high = m_slicePointItemList.size();
+
+    while ( low < high )
+    {
+        const int mid = ( low + high ) / 2;
+        const SlicePointItem* const item = m_slicePointItemList.at( mid ).data();
+        const int itemFrameNum = ( item == slicePointItem ) ? frameNum : item->getFrameNum();
+
+        if ( itemFrameNum < frameNum )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    for ( int i = low; i < m_slicePointItemList.size(); i++ )
+    {
+        const SlicePointItem* const item = m_slicePointItemList.at( i ).data();
+
+        if ( item == slicePointItem )
+        {
+            return i;
+        }
+
+        if ( item->getFrameNum() != frameNum )
+        {
+            break;
+        }
+    }
+
+    return -1;
+}
+
+
+
+QRectF WaveGraphicsScene::getVisibleItemsRect() const
+{
+    if ( views().isEmpty() )
+    {
+        return sceneRect();
+    }
+
+    const WaveGraphicsView* const view = getView();
+
+    const QRectF visibleRect = view->mapToScene( view->viewport()->rect() ).boundingRect();
+
+    return visibleRect.adjusted( -visibleRect.width(), 0.0, visibleRect.width(), 0.0 );
+}
+
+
+
+void WaveGraphicsScene::addVisibleItem( QGraphicsItem* const item )
+{
+    if ( item->scene() != this )
+    {
+        addItem( item );
+    }
+
+    m_visibleItems << item;
+}
+
+
+
+void WaveGraphicsScene::removeVisibleItem( QGraphicsItem* const item )
+{
+    if ( item->scene() == this )
+    {
+        removeItem( item );
+    }
+
+    m_visibleItems.remove( item );
+}
+
+
+
+void WaveGraphicsScene::updatePlayheadArea( const qreal scenePosX )
+{
+    foreach ( QGraphicsView* view, views() )
+    {
+        // A GL viewport has to be repainted in full
+        if ( view->viewportUpdateMode() == QGraphicsView::FullViewportUpdate )
+        {
+            view->viewport()->update();
+        }
+        else
+        {
+            const QPoint viewPos = view->mapFromScene( scenePosX, BpmRuler::HEIGHT );
+
+            view->viewport()->update( viewPos.x() - 2, viewPos.y(), 5, view->viewport()->height() - viewPos.y() );
+        }
+    }
+}
+
+
+
 //==================================================================================================
 // Private Static:
 
@@ -1028,6 +1265,8 @@ void WaveGraphicsScene::reorderWaveformItems( const QList<int> oldOrderPositions
             m_waveformItemList.move( orderPos, orderPos + numPlacesMoved );
         }
     }
+
+    updateVisibleItems();
 }
 
 
@@ -1042,52 +1281,41 @@ void WaveGraphicsScene::slideWaveformItemIntoPlace( const int orderPos )
     }
 
     m_waveformItemList.at( orderPos )->setPos( newScenePosX, BpmRuler::HEIGHT );
+
+    updateVisibleItems();
 }
 
 
 
 void WaveGraphicsScene::updateSlicePointOrdering( SlicePointItem* const movedItem, const int oldFrameNum )
 {
-    qSort( m_slicePointItemList.begin(), m_slicePointItemList.end(), SlicePointItem::isLessThanFrameNum );
+    // Move the item from its old place in the sorted list to its new place
+    const int oldIndex = getSlicePointIndex( movedItem, oldFrameNum );
 
-    SharedSlicePointItem sharedSlicePoint;
+    Q_ASSERT( oldIndex >= 0 );
 
-    int numFramesFromPrevSlicePoint = movedItem->getFrameNum();
-    int numFramesToNextSlicePoint = getTotalNumFrames( m_waveformItemList ) - movedItem->getFrameNum();
-    int orderPos = 0;
+    const SharedSlicePointItem sharedSlicePoint = m_slicePointItemList.at( oldIndex );
 
-    for ( int i = 0; i < m_slicePointItemList.size(); i++ )
-    {
-        SharedSlicePointItem item = m_slicePointItemList.at( i );
+    m_slicePointItemList.removeAt( oldIndex );
 
-        if ( item == movedItem )
-        {
-            sharedSlicePoint = item;
+    const int orderPos = getSlicePointInsertIndex( movedItem->getFrameNum() );
 
-            if ( i > 0 )
-            {
-                numFramesFromPrevSlicePoint = movedItem->getFrameNum() - m_slicePointItemList.at( i - 1 )->getFrameNum();
-            }
+    m_slicePointItemList.insert( orderPos, sharedSlicePoint );
 
-            if ( i < m_slicePointItemList.size() - 1 )
-            {
-                numFramesToNextSlicePoint = m_slicePointItemList.at( i + 1 )->getFrameNum() - movedItem->getFrameNum();
-            }
+    int numFramesFromPrevSlicePoint = movedItem->getFrameNum();
+    int numFramesToNextSlicePoint = getTotalNumFrames( m_waveformItemList ) - movedItem->getFrameNum();
 
-            orderPos = i;
-            break;
-        }
+    if ( orderPos > 0 )
+    {
+        numFramesFromPrevSlicePoint = movedItem->getFrameNum() - m_slicePointItemList.at( orderPos - 1 )->getFrameNum();
     }
 
-    emit slicePointPosChanged( sharedSlicePoint, orderPos, numFramesFromPrevSlicePoint, numFramesToNextSlicePoint, oldFrameNum );
-}
-
-
+    if ( orderPos < m_slicePointItemList.size() - 1 )
+    {
+        numFramesToNextSlicePoint = m_slicePointItemList.at( orderPos + 1 )->getFrameNum() - movedItem->getFrameNum();
+    }
 
-void WaveGraphicsScene::removePlayhead()
-{
-    removeItem( m_playhead );
-    update();
+    emit slicePointPosChanged( sharedSlicePoint, orderPos, numFramesFromPrevSlicePoint, numFramesToNextSlicePoint, oldFrameNum );
 }
 
 
@@ -24,8 +24,7 @@
 #define WAVEGRAPHICSSCENE_H
 
 #include <QGraphicsScene>
-#include <QTimeLine>
-#include <QGraphicsItemAnimation>
+#include <QSet>
 #include "JuceHeader.h"
 #include "waveformitem.h"
 #include "slicepointitem.h"
@@ -107,24 +106,33 @@ public:
     // Returns a sorted and edited list containing the frame no. of every valid slice point item
     QList<int> getSlicePointFrameNums() const;
 
-    // Returns a list of all slice point items
+    // Returns a list of all slice point items sorted by frame no.
     QList<SharedSlicePointItem> getSlicePointList() const   { return m_slicePointItemList; }
 
+    // Return the slice point items immediately before and after 'slicePointItem' in frame order,
+    // or a null pointer if there isn't one
+    SharedSlicePointItem getPrevSlicePoint( const SlicePointItem* slicePointItem ) const;
+    SharedSlicePointItem getNextSlicePoint( const SlicePointItem* slicePointItem ) const;
+
     void selectNone();
     void selectAll();
 
-    void startPlayhead( bool isLoopingDesired, qreal stretchRatio = 1.0 );
-    void startPlayhead( qreal startPosX,
-                        qreal endPosX,
-                        int numFrames,
-                        bool isLoopingDesired,
-                        qreal stretchRatio = 1.0 );
+    // Show the playhead at 'startPosX'; it reaches 'endPosX' after 'numFrames' frames have been played
+    void startPlayhead();
+    void startPlayhead( qreal startPosX, qreal endPosX, int numFrames );
+
+    // Move the playhead to the position reached after playing 'frameNum' frames. This is driven by the
+    // audio clock rather than a timeline so that the playhead stays in sync with what is being heard
+    void updatePlayhead( int frameNum );
+
     void stopPlayhead();
-    bool isPlayheadScrolling() const                        { return m_timer->state() == QTimeLine::Running; }
-    void setPlayheadLooping( bool isLoopingDesired );
-    void updatePlayheadSpeed( qreal stretchRatio );
+    bool isPlayheadScrolling() const                        { return m_isPlayheadScrolling; }
 
     QList<SharedGraphicsItem> getBpmRulerMarks() const      { return m_rulerMarksList; }
+
+    // Returns the BPM ruler mark closest to 'scenePosX', or a null pointer if there are no ruler marks
+    SharedGraphicsItem getNearestBpmRulerMark( qreal scenePosX ) const;
+
     void setBpmRulerMarks( qreal bpm, int timeSigNumerator, int divisionsPerBeat );
 
     void clearAll();
@@ -138,11 +146,20 @@ public:
 
     void resizeWaveformItems( qreal scaleFactorX );
     void resizeSlicePointItems( qreal scaleFactorX );
-    void resizePlayhead();
+    void resizePlayhead( qreal scaleFactorX );
     void resizeRuler( qreal scaleFactorX );
 
     void scaleItems( qreal scaleFactorX );
 
+    // Only waveform and slice point items in or near the visible part of the view are added to the scene so that
+    // large numbers of slices stay responsive. This adds items that have come into range and removes those that
+    // have gone out of range; selected items and the item being dragged are always kept in the scene
+    void updateVisibleItems();
+
+protected:
+    // Draws the playhead on top of all items
+    void drawForeground( QPainter* painter, const QRectF& rect );
+
 private:
     WaveGraphicsView* getView() const;
 
@@ -150,19 +167,43 @@ private:
 
     void createBpmRuler();
 
+    // Returns the index at which a slice point at 'frameNum' should be inserted to keep the list sorted
+    int getSlicePointInsertIndex( int frameNum ) const;
+
+    // Returns the index of 'slicePointItem' in the slice point list, or -1 if it isn't in the list.
+    // 'frameNum' is the item's frame no. when the list was last sorted, in case it has since changed
+    int getSlicePointIndex( const SlicePointItem* slicePointItem, int frameNum ) const;
+
+    // Returns the part of the scene whose items are added to the scene: the visible area plus a margin either side
+    QRectF getVisibleItemsRect() const;
+
+    void addVisibleItem( QGraphicsItem* item );
+    void removeVisibleItem( QGraphicsItem* item );
+
+    // Repaint the part of each view covered by the playhead at 'scenePosX'
+    void updatePlayheadArea( qreal scenePosX );
+
     InteractionMode m_interactionMode;
 
     QList<SharedWaveformItem> m_waveformItemList;
+
+    // Kept sorted by frame no. so that neighbouring slice points can be found with a binary search
     QList<SharedSlicePointItem> m_slicePointItemList;
 
+    // The waveform and slice point items that are currently in the scene
+    QSet<QGraphicsItem*> m_visibleItems;
+
+    // Sorted by scene position
     QList<SharedGraphicsItem> m_rulerMarksList;
     ScopedPointer<QGraphicsRectItem> m_rulerBackground;
 
     SharedSampleHeader m_sampleHeader;
 
-    ScopedPointer<QGraphicsLineItem> m_playhead;
-    ScopedPointer<QTimeLine> m_timer;
-    ScopedPointer<QGraphicsItemAnimation> m_animation;
+    bool m_isPlayheadScrolling;
+    qreal m_playheadStartPosX;
+    qreal m_playheadEndPosX;
+    qreal m_playheadPosX;
+    int m_playheadNumFrames;
 
     bool m_isSceneAtSampleDetailLevel;
 
@@ -175,7 +216,6 @@ signals:
                                int numFramesFromPrevSlicePoint,
                                int numFramesToNextSlicePoint,
                                int oldFrameNum );
-    void playheadFinishedScrolling();
 
 private slots:
     // 'oldOrderPositions' is assumed to be sorted
@@ -184,7 +224,6 @@ private slots:
 
     void slideWaveformItemIntoPlace( int orderPos );
     void updateSlicePointOrdering( SlicePointItem* movedItem, int oldFrameNum );
-    void removePlayhead();
 
     void setSceneDetailLevelToSamples();
     void setSceneDetailLevelToSampleBins();
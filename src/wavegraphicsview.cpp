@@ -22,6 +22,7 @@
 
 #include "wavegraphicsview.h"
 #include <QGLWidget>
+#include <QPixmapCache>
 #include <QDebug>
 
 
@@ -46,6 +47,9 @@ WaveGraphicsView::WaveGraphicsView( QWidget* parent ) :
     setBackgroundBrush( Qt::gray );
     setCacheMode( CacheBackground );
 
+    // Waveform items cache their rendered tiles in the global pixmap cache
+    QPixmapCache::setCacheLimit( PIXMAP_CACHE_LIMIT );
+
     m_scene = new WaveGraphicsScene( 0.0, 0.0, 1024.0, 768.0 );
     setScene( m_scene );
 }
@@ -70,6 +74,7 @@ void WaveGraphicsView::zoomIn()
     setTransform( matrix );
 
     m_scene->scaleItems( newXScaleFactor );
+    m_scene->updateVisibleItems();
 }
 
 
@@ -83,6 +88,7 @@ void WaveGraphicsView::zoomOut()
     setTransform( matrix );
 
     m_scene->scaleItems( newXScaleFactor );
+    m_scene->updateVisibleItems();
 
     if ( newXScaleFactor <= 1.0 )
     {
@@ -99,6 +105,7 @@ void WaveGraphicsView::zoomOriginal()
 
     resetTransform();
     m_scene->scaleItems( 1.0 );
+    m_scene->updateVisibleItems();
 }
 
 
@@ -114,10 +121,24 @@ void WaveGraphicsView::resizeEvent( QResizeEvent* event )
 
     m_scene->resizeWaveformItems( scaleFactorX );
     m_scene->resizeSlicePointItems( scaleFactorX );
-    m_scene->resizePlayhead();
+    m_scene->resizePlayhead( scaleFactorX );
     m_scene->resizeRuler( scaleFactorX );
 
     QGraphicsView::resizeEvent( event );
+
+    m_scene->updateVisibleItems();
+}
+
+
+
+void WaveGraphicsView::scrollContentsBy( const int dx, const int dy )
+{
+    QGraphicsView::scrollContentsBy( dx, dy );
+
+    if ( m_scene != NULL )
+    {
+        m_scene->updateVisibleItems();
+    }
 }
 
 
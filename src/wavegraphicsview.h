@@ -46,12 +46,15 @@ public:
 
 protected:
     void resizeEvent( QResizeEvent* event );
+    void scrollContentsBy( int dx, int dy );
 
 private:
     ScopedPointer<WaveGraphicsScene> m_scene;
 
     bool m_isViewZoomedIn;
 
+    static const int PIXMAP_CACHE_LIMIT = 65536; // Kilobytes
+
 signals:
     void minDetailLevelReached();
     void maxDetailLevelReached();
@@ -0,0 +1,177 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "zerocrossingindex.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+
+//==================================================================================================
+// Public:
+
+ZeroCrossingIndex::ZeroCrossingIndex( const SharedSampleBuffer sampleBuffer ) :
+    m_numFrames( sampleBuffer->getNumFrames() ),
+    m_numWordsPerChan( ( sampleBuffer->getNumFrames() + 31 ) / 32 ),
+    m_runStartBits( (size_t) m_numWordsPerChan * sampleBuffer->getNumChannels() )
+{
+    const int numChans = sampleBuffer->getNumChannels();
+
+    for ( int chanNum = 0; chanNum < numChans; chanNum++ )
+    {
+        const float* const sampleData = sampleBuffer->getReadPointer( chanNum );
+        uint32* const runStartBits = m_runStartBits + chanNum * m_numWordsPerChan;
+
+        // The signs of the frame before the current word. For the first word these are made to differ
+        // from the first frame, which always starts a run
+        uint32 prevIsPositive = ( m_numFrames > 0 && sampleData[ 0 ] > 0.0f ) ? 0 : 1;
+        uint32 prevIsNegative = 0;
+
+        for ( int wordNum = 0; wordNum < m_numWordsPerChan; wordNum++ )
+        {
+            const int startFrame = wordNum * 32;
+            const int numFramesInWord = jmin( m_numFrames - startFrame, 32 );
+
+            // Bit n is set if frame ( startFrame + n ) is above or below zero respectively
+            uint32 isPositive = 0;
+            uint32 isNegative = 0;
+            int frameNum = 0;
+
+#ifdef __SSE__
+            const __m128 zero = _mm_setzero_ps();
+
+            for ( ; frameNum + 4 <= numFramesInWord; frameNum += 4 )
+            {
+                const __m128 samples = _mm_loadu_ps( sampleData + startFrame + frameNum );
+
+                isPositive |= (uint32) _mm_movemask_ps( _mm_cmpgt_ps( samples, zero ) ) << frameNum;
+                isNegative |= (uint32) _mm_movemask_ps( _mm_cmplt_ps( samples, zero ) ) << frameNum;
+            }
+#endif
+
+            for ( ; frameNum < numFramesInWord; frameNum++ )
+            {
+                const float sample = sampleData[ startFrame + frameNum ];
+
+                isPositive |= (uint32) ( sample > 0.0f ) << frameNum;
+                isNegative |= (uint32) ( sample < 0.0f ) << frameNum;
+            }
+
+            // A run starts wherever a frame's sign differs from that of the frame before
+            uint32 runStarts = ( isPositive ^ ( isPositive << 1 | prevIsPositive ) ) |
+                               ( isNegative ^ ( isNegative << 1 | prevIsNegative ) );
+
+            // Clear the bits beyond the end of the buffer
+            if ( numFramesInWord < 32 )
+            {
+                runStarts &= ( 1u << numFramesInWord ) - 1;
+            }
+
+            runStartBits[ wordNum ] = runStarts;
+
+            prevIsPositive = isPositive >> 31;
+            prevIsNegative = isNegative >> 31;
+        }
+    }
+}
+
+
+
+bool ZeroCrossingIndex::isWorthBuilding( const int numFrames, const int numSearches )
+{
+    return numSearches > 0 && numFrames / numSearches <= MAX_FRAMES_PER_SEARCH;
+}
+
+
+
+int ZeroCrossingIndex::getStartOfRun( const int chanNum, const int frameNum ) const
+{
+    const uint32* const runStartBits = m_runStartBits + chanNum * m_numWordsPerChan;
+
+    // Find the last run start at or before "frameNum". The first frame always starts a run, so one will be found
+    int wordNum = frameNum / 32;
+    uint32 word = runStartBits[ wordNum ] & ( 0xFFFFFFFFu >> ( 31 - frameNum % 32 ) );
+
+    while ( word == 0 )
+    {
+        word = runStartBits[ --wordNum ];
+    }
+
+    return wordNum * 32 + findHighestSetBit( word );
+}
+
+
+
+int ZeroCrossingIndex::getEndOfRun( const int chanNum, const int frameNum ) const
+{
+    const uint32* const runStartBits = m_runStartBits + chanNum * m_numWordsPerChan;
+
+    // Find the first run start after "frameNum", if there is one
+    int wordNum = frameNum / 32;
+    uint32 word = ( frameNum % 32 == 31 ) ? 0 : runStartBits[ wordNum ] & ( 0xFFFFFFFFu << ( frameNum % 32 + 1 ) );
+
+    while ( word == 0 )
+    {
+        if ( ++wordNum == m_numWordsPerChan )
+        {
+            return m_numFrames;
+        }
+
+        word = runStartBits[ wordNum ];
+    }
+
+    return wordNum * 32 + findLowestSetBit( word );
+}
+
+
+
+//==================================================================================================
+// Private Static:
+
+int ZeroCrossingIndex::findLowestSetBit( uint32 word )
+{
+    int bitNum = 0;
+
+    while ( ( word & 1 ) == 0 )
+    {
+        word >>= 1;
+        bitNum++;
+    }
+
+    return bitNum;
+}
+
+
+
+int ZeroCrossingIndex::findHighestSetBit( uint32 word )
+{
+    int bitNum = 31;
+
+    while ( ( word & 0x80000000u ) == 0 )
+    {
+        word <<= 1;
+        bitNum--;
+    }
+
+    return bitNum;
+}
@@ -0,0 +1,68 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef ZEROCROSSINGINDEX_H
+#define ZEROCROSSINGINDEX_H
+
+#include "samplebuffer.h"
+
+
+// A precomputed index of where the "runs" of positive, negative and zero samples start in each channel of a sample
+// buffer, held as one bit per frame. Finding the sign changes either side of a frame then skips through the bits 32
+// frames at a time rather than scanning the sample data, which pays off when many zero-crossings need to be found
+// in the same buffer
+
+class ZeroCrossingIndex
+{
+public:
+    ZeroCrossingIndex( SharedSampleBuffer sampleBuffer );
+
+    // Returns true if "numSearches" zero-crossings are likely to be found more quickly in a buffer of "numFrames"
+    // frames by building an index first than by scanning the sample data for each one
+    static bool isWorthBuilding( int numFrames, int numSearches );
+
+    // Returns the first frame of the run containing "frameNum"
+    int getStartOfRun( int chanNum, int frameNum ) const;
+
+    // Returns the frame after the last frame of the run containing "frameNum"
+    int getEndOfRun( int chanNum, int frameNum ) const;
+
+private:
+    static int findLowestSetBit( uint32 word );
+    static int findHighestSetBit( uint32 word );
+
+    // Building the index reads every frame once, whereas a search without it only reads the run around its start
+    // frame. Runs are typically a few hundred frames long, so the index is only worth building if there is at
+    // least one search per this many frames
+    static const int MAX_FRAMES_PER_SEARCH = 1024;
+
+    const int m_numFrames;
+    const int m_numWordsPerChan;
+
+    // Bit n of word w of a channel is set if frame ( w * 32 + n ) is the first frame of a run
+    HeapBlock<uint32> m_runStartBits;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( ZeroCrossingIndex )
+};
+
+
+#endif // ZEROCROSSINGINDEX_H
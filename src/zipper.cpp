@@ -22,43 +22,26 @@
 
 #include "zipper.h"
 #include "JuceHeader.h"
-#include <QDebug>
 
 
 //==================================================================================================
 // Public Static:
 
-void Zipper::compress( const QString sourceDirPath, const QString zipFilePath )
+QStringList Zipper::getEntryNames( const QString zipFilePath )
 {
-    const File sourceDir( sourceDirPath.toLocal8Bit().data() );
     const File zipFile( zipFilePath.toLocal8Bit().data() );
-    const File parentDir = zipFile.getParentDirectory();
 
-    ZipFile::Builder zipBuilder;
-    Array<File> files;
+    QStringList entryNames;
 
-    sourceDir.findChildFiles( files, File::findFiles, false );
-
-    for ( int i = 0; i < files.size(); i++ )
+    if ( zipFile.existsAsFile() )
     {
-        zipBuilder.addFile( files[i], 9, files[i].getRelativePathFrom( parentDir ) );
-    }
+        const ZipFile zip( zipFile );
 
-    if ( zipFile.exists() )
-    {
-        zipFile.deleteFile();
+        for ( int i = 0; i < zip.getNumEntries(); i++ )
+        {
+            entryNames << QString::fromUtf8( zip.getEntry( i )->filename.toRawUTF8() );
+        }
     }
 
-    FileOutputStream stream( zipFile );
-    zipBuilder.writeToStream( stream, NULL );
-}
-
-
-
-void Zipper::decompress( const QString zipFilePath, const QString destDirPath )
-{
-    const File zipFile( zipFilePath.toLocal8Bit().data() );
-    const File destDir( destDirPath.toLocal8Bit().data() );
-
-    ZipFile( zipFile ).uncompressTo( destDir );
+    return entryNames;
 }
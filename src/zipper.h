@@ -24,13 +24,14 @@
 #define ZIPPER_H
 
 #include <QString>
+#include <QStringList>
 
 
 class Zipper
 {
 public:
-    static void compress( QString sourceDirPath, QString zipFilePath );
-    static void decompress( QString zipFilePath, QString destDirPath );
+    // Returns the names of the entries in the archive, or an empty list if it can't be read
+    static QStringList getEntryNames( QString zipFilePath );
 };
 
 #endif // ZIPPER_H
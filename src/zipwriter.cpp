@@ -0,0 +1,470 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "zipwriter.h"
+
+
+//==================================================================================================
+// Compresses the data written to it into the archive, keeping track of its checksum and size
+
+class ZipWriter::EntryStream : public OutputStream
+{
+public:
+    EntryStream( OutputStream& output, const Entry& entry, const int compressionLevel ) :
+        m_output( output ),
+        m_entry( entry ),
+        m_dataOffset( output.getPosition() )
+    {
+        if ( compressionLevel > 0 )
+        {
+            m_compressor = new GZIPCompressorOutputStream( &output, compressionLevel, false,
+                                                           GZIPCompressorOutputStream::windowBitsRaw );
+        }
+    }
+
+    // Flush any compressed data that is still buffered and return the finished entry
+    const Entry& finish()
+    {
+        m_compressor = nullptr;
+        m_entry.compressedSize = m_output.getPosition() - m_dataOffset;
+
+        return m_entry;
+    }
+
+    void flush() override                           {}
+    bool setPosition( int64 /*newPosition*/ ) override { return false; }
+    int64 getPosition() override                    { return m_entry.uncompressedSize; }
+
+    bool write( const void* const data, const size_t numBytes ) override
+    {
+        m_entry.checksum = updateChecksum( m_entry.checksum, static_cast<const uint8*>( data ), numBytes );
+        m_entry.uncompressedSize += numBytes;
+
+        if ( m_compressor != nullptr )
+        {
+            return m_compressor->write( data, numBytes );
+        }
+
+        return m_output.write( data, numBytes );
+    }
+
+private:
+    OutputStream& m_output;
+    Entry m_entry;
+    const int64 m_dataOffset;
+    ScopedPointer<GZIPCompressorOutputStream> m_compressor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( EntryStream )
+};
+
+
+
+//==================================================================================================
+// Public:
+
+ZipWriter::ZipWriter( const File& zipFile ) :
+    m_tempFile( zipFile ),
+    m_output( new FileOutputStream( m_tempFile.getFile() ) ),
+    m_isOk( true )
+{
+    if ( m_output->failedToOpen() )
+    {
+        m_output = nullptr;
+        m_isOk = false;
+    }
+}
+
+
+
+ZipWriter::~ZipWriter()
+{
+    // The entry stream may still be writing compressed data to the output stream
+    m_entryStream = nullptr;
+    m_output = nullptr;
+}
+
+
+
+OutputStream* ZipWriter::beginEntry( const String& entryName, const int compressionLevel )
+{
+    jassert( m_output != nullptr );
+
+    endEntry();
+
+    const Time modTime = Time::getCurrentTime();
+
+    Entry entry;
+
+    entry.name = entryName;
+    entry.flags = 1 << 11; // UTF-8 entry name
+    entry.compressionMethod = compressionLevel > 0 ? 8 : 0;
+    entry.modTime = modTime.getSeconds() / 2 + ( modTime.getMinutes() << 5 ) + ( modTime.getHours() << 11 );
+    entry.modDate = modTime.getDayOfMonth() + ( ( modTime.getMonth() + 1 ) << 5 ) + ( ( modTime.getYear() - 1980 ) << 9 );
+    entry.checksum = 0;
+    entry.compressedSize = 0;
+    entry.uncompressedSize = 0;
+    entry.headerOffset = m_output->getPosition();
+
+    // The checksum and sizes aren't known until all the data has been written,
+    // so the local header is written again by endEntry()
+    writeLocalHeader( *m_output, entry );
+
+    m_entryStream = new EntryStream( *m_output, entry, compressionLevel );
+
+    return m_entryStream;
+}
+
+
+
+bool ZipWriter::copyEntries( const File& sourceZipFile, const StringArray& entryNames )
+{
+    jassert( m_output != nullptr );
+
+    endEntry();
+
+    FileInputStream input( sourceZipFile );
+    Array<Entry> sourceEntries;
+
+    if ( input.failedToOpen() || ! readCentralDirectory( input, sourceEntries ) )
+    {
+        return false;
+    }
+
+    const int64 startOffset = m_output->getPosition();
+    const int numEntriesBefore = m_entries.size();
+
+    bool isSuccessful = true;
+
+    for ( int i = 0; i < sourceEntries.size() && isSuccessful; i++ )
+    {
+        Entry entry = sourceEntries.getReference( i );
+
+        if ( ! entryNames.contains( entry.name ) )
+        {
+            continue;
+        }
+
+        char header[ LOCAL_HEADER_SIZE ];
+
+        if ( ! input.setPosition( entry.headerOffset ) ||
+             input.read( header, LOCAL_HEADER_SIZE ) != LOCAL_HEADER_SIZE ||
+             ByteOrder::littleEndianInt( header ) != 0x04034b50 )
+        {
+            isSuccessful = false;
+            break;
+        }
+
+        const int nameLength = ByteOrder::littleEndianShort( header + 26 );
+        const int extraLength = ByteOrder::littleEndianShort( header + 28 );
+
+        input.setPosition( entry.headerOffset + LOCAL_HEADER_SIZE + nameLength + extraLength );
+
+        // The sizes are written in the new local header, so any data descriptor following the data is dropped
+        entry.flags &= ~0x08;
+        entry.headerOffset = m_output->getPosition();
+
+        writeLocalHeader( *m_output, entry );
+
+        isSuccessful = isWithinZip32Limits( entry ) &&
+                       m_output->writeFromInputStream( input, entry.compressedSize ) == entry.compressedSize;
+
+        if ( isSuccessful )
+        {
+            m_entries.add( entry );
+        }
+    }
+
+    // Leave the archive as it was, so the caller can write the entries some other way
+    if ( ! isSuccessful )
+    {
+        m_entries.resize( numEntriesBefore );
+
+        if ( ! m_output->setPosition( startOffset ) || m_output->truncate().failed() )
+        {
+            m_isOk = false;
+        }
+    }
+
+    return isSuccessful;
+}
+
+
+
+bool ZipWriter::finish()
+{
+    if ( m_output == nullptr )
+    {
+        return false;
+    }
+
+    endEntry();
+
+    if ( ! writeCentralDirectory( *m_output, m_entries ) )
+    {
+        m_isOk = false;
+    }
+
+    m_output->flush();
+
+    if ( m_output->getStatus().failed() )
+    {
+        m_isOk = false;
+    }
+
+    m_output = nullptr;
+
+    return m_isOk && m_tempFile.overwriteTargetFileWithTemporary();
+}
+
+
+
+//==================================================================================================
+// Private:
+
+bool ZipWriter::endEntry()
+{
+    if ( m_entryStream == nullptr )
+    {
+        return m_isOk;
+    }
+
+    const Entry entry = m_entryStream->finish();
+    m_entryStream = nullptr;
+
+    if ( ! isWithinZip32Limits( entry ) )
+    {
+        m_isOk = false;
+    }
+
+    const int64 endOffset = m_output->getPosition();
+
+    if ( m_output->setPosition( entry.headerOffset ) )
+    {
+        writeLocalHeader( *m_output, entry );
+    }
+
+    if ( ! m_output->setPosition( endOffset ) )
+    {
+        m_isOk = false;
+    }
+
+    m_entries.add( entry );
+
+    return m_isOk;
+}
+
+
+
+//==================================================================================================
+// Private Static:
+
+bool ZipWriter::readCentralDirectory( InputStream& input, Array<Entry>& entries )
+{
+    // The end of central directory record is followed by a comment of up to 65535 bytes
+    const int64 totalLength = input.getTotalLength();
+    const int searchLength = (int) jmin( totalLength, (int64) 65535 + END_OF_DIRECTORY_SIZE );
+
+    MemoryBlock tail;
+
+    if ( ! input.setPosition( totalLength - searchLength ) || input.readIntoMemoryBlock( tail, searchLength ) != searchLength )
+    {
+        return false;
+    }
+
+    const char* const tailData = static_cast<const char*>( tail.getData() );
+    int endOfDirPos = -1;
+
+    for ( int i = searchLength - END_OF_DIRECTORY_SIZE; i >= 0; i-- )
+    {
+        if ( ByteOrder::littleEndianInt( tailData + i ) == 0x06054b50 )
+        {
+            endOfDirPos = i;
+            break;
+        }
+    }
+
+    if ( endOfDirPos < 0 )
+    {
+        return false;
+    }
+
+    const int numEntries = ByteOrder::littleEndianShort( tailData + endOfDirPos + 10 );
+    const int directorySize = (int) ByteOrder::littleEndianInt( tailData + endOfDirPos + 12 );
+    const int64 directoryOffset = (int64) ByteOrder::littleEndianInt( tailData + endOfDirPos + 16 );
+
+    MemoryBlock directory;
+
+    if ( ! input.setPosition( directoryOffset ) || input.readIntoMemoryBlock( directory, directorySize ) != directorySize )
+    {
+        return false;
+    }
+
+    const char* const directoryData = static_cast<const char*>( directory.getData() );
+    int pos = 0;
+
+    for ( int i = 0; i < numEntries; i++ )
+    {
+        if ( pos + DIRECTORY_ENTRY_SIZE > directorySize ||
+             ByteOrder::littleEndianInt( directoryData + pos ) != 0x02014b50 )
+        {
+            return false;
+        }
+
+        const char* const header = directoryData + pos;
+        const int nameLength = ByteOrder::littleEndianShort( header + 28 );
+        const int extraLength = ByteOrder::littleEndianShort( header + 30 );
+        const int commentLength = ByteOrder::littleEndianShort( header + 32 );
+
+        if ( pos + DIRECTORY_ENTRY_SIZE + nameLength > directorySize )
+        {
+            return false;
+        }
+
+        Entry entry;
+
+        entry.flags = ByteOrder::littleEndianShort( header + 8 );
+        entry.compressionMethod = ByteOrder::littleEndianShort( header + 10 );
+        entry.modTime = ByteOrder::littleEndianShort( header + 12 );
+        entry.modDate = ByteOrder::littleEndianShort( header + 14 );
+        entry.checksum = ByteOrder::littleEndianInt( header + 16 );
+        entry.compressedSize = (int64) ByteOrder::littleEndianInt( header + 20 );
+        entry.uncompressedSize = (int64) ByteOrder::littleEndianInt( header + 24 );
+        entry.headerOffset = (int64) ByteOrder::littleEndianInt( header + 42 );
+        entry.name = String::fromUTF8( header + DIRECTORY_ENTRY_SIZE, nameLength );
+
+        entries.add( entry );
+
+        pos += DIRECTORY_ENTRY_SIZE + nameLength + extraLength + commentLength;
+    }
+
+    return true;
+}
+
+
+
+bool ZipWriter::isWithinZip32Limits( const Entry& entry )
+{
+    return entry.compressedSize <= MAX_ZIP32_SIZE &&
+           entry.uncompressedSize <= MAX_ZIP32_SIZE &&
+           entry.headerOffset <= MAX_ZIP32_SIZE;
+}
+
+
+
+void ZipWriter::writeLocalHeader( OutputStream& output, const Entry& entry )
+{
+    output.writeInt( 0x04034b50 );
+    output.writeShort( 20 ); // Version needed to extract
+    output.writeShort( (short) entry.flags );
+    output.writeShort( (short) entry.compressionMethod );
+    output.writeShort( (short) entry.modTime );
+    output.writeShort( (short) entry.modDate );
+    output.writeInt( (int) entry.checksum );
+    output.writeInt( (int) (uint32) entry.compressedSize );
+    output.writeInt( (int) (uint32) entry.uncompressedSize );
+    output.writeShort( (short) entry.name.getNumBytesAsUTF8() );
+    output.writeShort( 0 ); // Extra field length
+    output.write( entry.name.toRawUTF8(), entry.name.getNumBytesAsUTF8() );
+}
+
+
+
+bool ZipWriter::writeCentralDirectory( OutputStream& output, const Array<Entry>& entries )
+{
+    const int64 directoryOffset = output.getPosition();
+
+    for ( int i = 0; i < entries.size(); i++ )
+    {
+        const Entry& entry = entries.getReference( i );
+
+        output.writeInt( 0x02014b50 );
+        output.writeShort( 20 ); // Version made by
+        output.writeShort( 20 ); // Version needed to extract
+        output.writeShort( (short) entry.flags );
+        output.writeShort( (short) entry.compressionMethod );
+        output.writeShort( (short) entry.modTime );
+        output.writeShort( (short) entry.modDate );
+        output.writeInt( (int) entry.checksum );
+        output.writeInt( (int) (uint32) entry.compressedSize );
+        output.writeInt( (int) (uint32) entry.uncompressedSize );
+        output.writeShort( (short) entry.name.getNumBytesAsUTF8() );
+        output.writeShort( 0 ); // Extra field length
+        output.writeShort( 0 ); // Comment length
+        output.writeShort( 0 ); // Disk number start
+        output.writeShort( 0 ); // Internal attributes
+        output.writeInt( 0 );   // External attributes
+        output.writeInt( (int) (uint32) entry.headerOffset );
+        output.write( entry.name.toRawUTF8(), entry.name.getNumBytesAsUTF8() );
+    }
+
+    const int64 directoryEnd = output.getPosition();
+
+    output.writeInt( 0x06054b50 );
+    output.writeShort( 0 ); // Number of this disk
+    output.writeShort( 0 ); // Disk where the central directory starts
+    output.writeShort( (short) entries.size() );
+    output.writeShort( (short) entries.size() );
+    output.writeInt( (int) ( directoryEnd - directoryOffset ) );
+    output.writeInt( (int) (uint32) directoryOffset );
+    output.writeShort( 0 ); // Comment length
+
+    return entries.size() <= MAX_ZIP32_ENTRIES &&
+           directoryOffset <= MAX_ZIP32_SIZE &&
+           directoryEnd - directoryOffset <= MAX_ZIP32_SIZE;
+}
+
+
+
+uint32 ZipWriter::updateChecksum( uint32 checksum, const uint8* const data, const size_t numBytes )
+{
+    // Standard CRC-32, as used by zip and gzip. The table is built once, the first time it is needed
+    struct ChecksumTable
+    {
+        ChecksumTable()
+        {
+            for ( uint32 i = 0; i < 256; i++ )
+            {
+                uint32 value = i;
+
+                for ( int bit = 0; bit < 8; bit++ )
+                {
+                    value = ( value & 1 ) ? 0xedb88320 ^ ( value >> 1 ) : value >> 1;
+                }
+
+                values[ i ] = value;
+            }
+        }
+
+        uint32 values[ 256 ];
+    };
+
+    static const ChecksumTable table;
+
+    checksum = ~checksum;
+
+    for ( size_t i = 0; i < numBytes; i++ )
+    {
+        checksum = table.values[ ( checksum ^ data[ i ] ) & 0xff ] ^ ( checksum >> 8 );
+    }
+
+    return ~checksum;
+}
@@ -0,0 +1,103 @@
+/*
+  This file is part of Shuriken Beat Slicer.
+
+  Copyright (C) 2016 Andrew M Taylor <a.m.taylor303@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>
+  or write to the Free Software Foundation, Inc., 51 Franklin Street,
+  Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include "JuceHeader.h"
+
+
+// Writes a zip archive in a single pass. The data of each entry is compressed as it is written to the stream
+// returned by beginEntry(), so nothing has to be staged on disk first. The archive is written to a temp file
+// next to the destination file, which is only replaced once finish() has written the whole archive
+
+class ZipWriter
+{
+public:
+    ZipWriter( const File& zipFile );
+    ~ZipWriter();
+
+    bool failedToOpen() const                       { return m_output == nullptr; }
+
+    // Start a new entry and return the stream its data should be written to. The stream remains valid until
+    // the next call to beginEntry(), copyEntries() or finish(). A "compressionLevel" of 0 stores the data as it is
+    OutputStream* beginEntry( const String& entryName, int compressionLevel );
+
+    // Copy the named entries from an existing archive without decompressing them. This can read from the
+    // archive that is being replaced, as it isn't touched until finish() is called. Either all of the entries
+    // that are found are copied, or none are and false is returned
+    bool copyEntries( const File& sourceZipFile, const StringArray& entryNames );
+
+    // Write the central directory and move the archive into place. Returns false if anything went wrong
+    // while writing the archive, in which case the destination file is left untouched. Zip64 isn't supported,
+    // so that includes any entry, or the archive itself, growing beyond 4 GiB
+    bool finish();
+
+private:
+    // The details of an entry that are recorded in both its local header and the central directory
+    struct Entry
+    {
+        String name;
+        int flags;
+        int compressionMethod;
+        int modTime;
+        int modDate;
+        uint32 checksum;
+        int64 compressedSize;
+        int64 uncompressedSize;
+        int64 headerOffset;
+    };
+
+    class EntryStream;
+
+    bool endEntry();
+
+    static bool readCentralDirectory( InputStream& input, Array<Entry>& entries );
+
+    // Returns false if the entry's sizes or offset don't fit in the 32-bit fields of a non-zip64 archive
+    static bool isWithinZip32Limits( const Entry& entry );
+
+    static void writeLocalHeader( OutputStream& output, const Entry& entry );
+
+    // Returns false if the directory's size, offset or no. of entries don't fit in a non-zip64 archive
+    static bool writeCentralDirectory( OutputStream& output, const Array<Entry>& entries );
+
+    static uint32 updateChecksum( uint32 checksum, const uint8* data, size_t numBytes );
+
+    TemporaryFile m_tempFile;
+    ScopedPointer<FileOutputStream> m_output;
+
+    Array<Entry> m_entries;
+    ScopedPointer<EntryStream> m_entryStream;
+    bool m_isOk;
+
+    static const int LOCAL_HEADER_SIZE = 30;
+    static const int DIRECTORY_ENTRY_SIZE = 46;
+    static const int END_OF_DIRECTORY_SIZE = 22;
+
+    static const int64 MAX_ZIP32_SIZE = 0xFFFFFFFF;
+    static const int MAX_ZIP32_ENTRIES = 0xFFFF;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( ZipWriter )
+};
+
+#endif // ZIPWRITER_H